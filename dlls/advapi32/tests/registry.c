@@ -4535,6 +4535,82 @@ static void test_RegRenameKey(void)
     RegCloseKey(key);
 }
 
+static void test_many_subkeys(void)
+{
+    char name[32], buffer[32];
+    HKEY key, subkey;
+    DWORD i, len, type, data;
+    LSTATUS ret, expect;
+
+    ret = RegCreateKeyExA(hkey_main, "ManySubkeys", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+
+    /* create enough subkeys and values for them to be indexed, in mixed order */
+    for (i = 0; i < 300; i++)
+    {
+        sprintf(name, "Key%03lu", (i * 7) % 300);
+        ret = RegCreateKeyExA(key, name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &subkey, NULL);
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+        RegCloseKey(subkey);
+        sprintf(name, "Value%03lu", (i * 7) % 300);
+        data = (i * 7) % 300;
+        ret = RegSetValueExA(key, name, 0, REG_DWORD, (BYTE *)&data, sizeof(data));
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+    }
+
+    for (i = 0; i < 300; i++)
+    {
+        sprintf(name, "kEY%03lu", i);
+        ret = RegOpenKeyExA(key, name, 0, KEY_READ, &subkey);
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+        RegCloseKey(subkey);
+        sprintf(name, "vALUE%03lu", i);
+        len = sizeof(data);
+        ret = RegQueryValueExA(key, name, NULL, &type, (BYTE *)&data, &len);
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+        ok(data == i, "%s: got %lu.\n", name, data);
+
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA(key, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "unexpected return value %ld.\n", ret);
+        sprintf(name, "Key%03lu", i);
+        ok(!strcmp(buffer, name), "got %s, expected %s.\n", buffer, name);
+        len = sizeof(buffer);
+        ret = RegEnumValueA(key, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "unexpected return value %ld.\n", ret);
+        sprintf(name, "Value%03lu", i);
+        ok(!strcmp(buffer, name), "got %s, expected %s.\n", buffer, name);
+    }
+
+    for (i = 0; i < 300; i += 2)
+    {
+        sprintf(name, "Key%03lu", i);
+        ret = RegDeleteKeyA(key, name);
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+        sprintf(name, "Value%03lu", i);
+        ret = RegDeleteValueA(key, name);
+        ok(!ret, "%s: unexpected return value %ld.\n", name, ret);
+    }
+
+    ret = RegRenameKey(key, L"Key001", L"Key000");
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+
+    for (i = 0; i < 300; i++)
+    {
+        sprintf(name, "Key%03lu", i);
+        ret = RegOpenKeyExA(key, name, 0, KEY_READ, &subkey);
+        expect = (!i || (i % 2 && i != 1)) ? ERROR_SUCCESS : ERROR_FILE_NOT_FOUND;
+        ok(ret == expect, "%s: unexpected return value %ld.\n", name, ret);
+        if (!ret) RegCloseKey(subkey);
+        sprintf(name, "Value%03lu", i);
+        ret = RegQueryValueExA(key, name, NULL, NULL, NULL, NULL);
+        ok(ret == (i % 2 ? ERROR_SUCCESS : ERROR_FILE_NOT_FOUND), "%s: unexpected return value %ld.\n", name, ret);
+    }
+
+    delete_key(key);
+    RegCloseKey(key);
+}
+
 START_TEST(registry)
 {
     /* Load pointers for functions that are not available in all Windows versions */
@@ -4576,6 +4652,7 @@ START_TEST(registry)
     test_EnumDynamicTimeZoneInformation();
     test_perflib_key();
     test_RegRenameKey();
+    test_many_subkeys();
 
     /* cleanup */
     delete_key( hkey_main );
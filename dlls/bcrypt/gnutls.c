@@ -828,6 +828,52 @@ static NTSTATUS key_symmetric_set_auth_data( void *args )
     return STATUS_SUCCESS;
 }
 
+/* ECB is emulated with a CBC handle starting from an empty IV; cancel out the chaining
+ * so that several blocks can be processed without resetting the handle in between */
+static NTSTATUS ecb_crypt( struct key *key, const UCHAR *input, unsigned len, UCHAR *output, BOOL encrypt )
+{
+    ULONG i, j, size, block_size = key->u.s.block_size;
+    UCHAR chain[16] = {0}, buf[4096];
+    int ret = 0;
+
+    if (block_size > sizeof(chain)) return STATUS_NOT_SUPPORTED;
+    len -= len % block_size;
+
+    if (encrypt)
+    {
+        /* each block is chained to the previous output, so they have to go one by one */
+        for (i = 0; i < len && !ret; i += block_size)
+        {
+            for (j = 0; j < block_size; j++) buf[j] = input[i + j] ^ chain[j];
+            if (!(ret = pgnutls_cipher_encrypt2( key_data(key)->cipher, buf, block_size, output + i, block_size )))
+                memcpy( chain, output + i, block_size );
+        }
+    }
+    else
+    {
+        /* decrypted blocks are chained to the previous input, so whole runs can be
+         * decrypted at once from a copy, which also allows decrypting in place */
+        for (i = 0; i < len && !ret; i += size)
+        {
+            size = min( len - i, sizeof(buf) );
+            memcpy( buf, input + i, size );
+            if (!(ret = pgnutls_cipher_decrypt2( key_data(key)->cipher, buf, size, output + i, size )))
+            {
+                for (j = 0; j < block_size; j++) output[i + j] ^= chain[j];
+                for (j = block_size; j < size; j++) output[i + j] ^= buf[j - block_size];
+                memcpy( chain, buf + size - block_size, block_size );
+            }
+        }
+    }
+
+    if (ret)
+    {
+        pgnutls_perror( ret );
+        return STATUS_INTERNAL_ERROR;
+    }
+    return STATUS_SUCCESS;
+}
+
 static NTSTATUS key_symmetric_encrypt( void *args )
 {
     const struct key_symmetric_encrypt_params *params = args;
@@ -835,6 +881,8 @@ static NTSTATUS key_symmetric_encrypt( void *args )
     int ret;
 
     if ((status = init_cipher_handle( params->key ))) return status;
+    if (params->key->u.s.mode == CHAIN_MODE_ECB)
+        return ecb_crypt( params->key, params->input, params->input_len, params->output, TRUE );
 
     if ((ret = pgnutls_cipher_encrypt2( key_data(params->key)->cipher, params->input, params->input_len,
                                         params->output, params->output_len )))
@@ -852,6 +900,8 @@ static NTSTATUS key_symmetric_decrypt( void *args )
     int ret;
 
     if ((status = init_cipher_handle( params->key ))) return status;
+    if (params->key->u.s.mode == CHAIN_MODE_ECB)
+        return ecb_crypt( params->key, params->input, params->input_len, params->output, FALSE );
 
     if ((ret = pgnutls_cipher_decrypt2( key_data(params->key)->cipher, params->input, params->input_len,
                                         params->output, params->output_len )))
@@ -42,9 +42,21 @@ static const DWORD K[64] =
   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
+/* one round with the working variables renamed instead of shifted */
+#define ROUND(a,b,c,d,e,f,g,h,i) \
+    do { \
+        DWORD t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[(i) & 15]; \
+        d += t1; \
+        h = t1 + S0(a) + Maj(a,b,c); \
+    } while (0)
+
+/* extend the message schedule in place, keeping only the last 16 words */
+#define EXPAND(i) \
+    (W[(i) & 15] += R1(W[((i) - 2) & 15]) + W[((i) - 7) & 15] + R0(W[((i) - 15) & 15]))
+
 static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
 {
-    DWORD W[64], t1, t2, a, b, c, d, e, f, g, h;
+    DWORD W[16], a, b, c, d, e, f, g, h;
     int i;
 
     for (i = 0; i < 16; i++)
@@ -55,9 +67,6 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
         W[i] |= buffer[4*i+3];
     }
 
-    for (; i < 64; i++)
-        W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
-
     a = ctx->h[0];
     b = ctx->h[1];
     c = ctx->h[2];
@@ -67,18 +76,21 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     g = ctx->h[6];
     h = ctx->h[7];
 
-    for (i = 0; i < 64; i++)
+    for (i = 0; i < 64; i += 8)
     {
-        t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
-        t2 = S0(a) + Maj(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        if (i >= 16)
+        {
+            EXPAND(i);   EXPAND(i+1); EXPAND(i+2); EXPAND(i+3);
+            EXPAND(i+4); EXPAND(i+5); EXPAND(i+6); EXPAND(i+7);
+        }
+        ROUND(a,b,c,d,e,f,g,h,i);
+        ROUND(h,a,b,c,d,e,f,g,i+1);
+        ROUND(g,h,a,b,c,d,e,f,i+2);
+        ROUND(f,g,h,a,b,c,d,e,i+3);
+        ROUND(e,f,g,h,a,b,c,d,i+4);
+        ROUND(d,e,f,g,h,a,b,c,i+5);
+        ROUND(c,d,e,f,g,h,a,b,i+6);
+        ROUND(b,c,d,e,f,g,h,a,i+7);
     }
 
     ctx->h[0] += a;
@@ -55,9 +55,21 @@ static const ULONG64 K[80] =
     ULL(0x4cc5d4be,0xcb3e42b6), ULL(0x597f299c,0xfc657e2a), ULL(0x5fcb6fab,0x3ad6faec), ULL(0x6c44198c,0x4a475817)
 };
 
+/* one round with the working variables renamed instead of shifted */
+#define ROUND(a,b,c,d,e,f,g,h,i) \
+    do { \
+        ULONG64 t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[(i) & 15]; \
+        d += t1; \
+        h = t1 + S0(a) + Maj(a,b,c); \
+    } while (0)
+
+/* extend the message schedule in place, keeping only the last 16 words */
+#define EXPAND(i) \
+    (W[(i) & 15] += R1(W[((i) - 2) & 15]) + W[((i) - 7) & 15] + R0(W[((i) - 15) & 15]))
+
 static void processblock(SHA512_CTX *ctx, const UCHAR *buffer)
 {
-    ULONG64 W[80], t1, t2, a, b, c, d, e, f, g, h;
+    ULONG64 W[16], a, b, c, d, e, f, g, h;
     int i;
 
     for (i = 0; i < 16; i++)
@@ -72,9 +84,6 @@ static void processblock(SHA512_CTX *ctx, const UCHAR *buffer)
         W[i] |= buffer[8*i+7];
     }
 
-    for (; i < 80; i++)
-        W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
-
     a = ctx->h[0];
     b = ctx->h[1];
     c = ctx->h[2];
@@ -84,18 +93,21 @@ static void processblock(SHA512_CTX *ctx, const UCHAR *buffer)
     g = ctx->h[6];
     h = ctx->h[7];
 
-    for (i = 0; i < 80; i++)
+    for (i = 0; i < 80; i += 8)
     {
-        t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
-        t2 = S0(a) + Maj(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        if (i >= 16)
+        {
+            EXPAND(i);   EXPAND(i+1); EXPAND(i+2); EXPAND(i+3);
+            EXPAND(i+4); EXPAND(i+5); EXPAND(i+6); EXPAND(i+7);
+        }
+        ROUND(a,b,c,d,e,f,g,h,i);
+        ROUND(h,a,b,c,d,e,f,g,i+1);
+        ROUND(g,h,a,b,c,d,e,f,i+2);
+        ROUND(f,g,h,a,b,c,d,e,i+3);
+        ROUND(e,f,g,h,a,b,c,d,i+4);
+        ROUND(d,e,f,g,h,a,b,c,i+5);
+        ROUND(c,d,e,f,g,h,a,b,i+6);
+        ROUND(b,c,d,e,f,g,h,a,i+7);
     }
 
     ctx->h[0] += a;
@@ -1722,8 +1722,8 @@ static void test_BCryptDecrypt(void)
     BCRYPT_AUTH_TAG_LENGTHS_STRUCT tag_lengths;
     BCRYPT_ALG_HANDLE aes;
     BCRYPT_KEY_HANDLE key;
-    UCHAR *buf, plaintext[48], ivbuf[16];
-    ULONG size, len;
+    UCHAR *buf, *large, plaintext[48], ivbuf[16];
+    ULONG size, len, i;
     NTSTATUS ret;
 
     ret = BCryptOpenAlgorithmProvider(&aes, BCRYPT_AES_ALGORITHM, NULL, 0);
@@ -2012,6 +2012,18 @@ static void test_BCryptDecrypt(void)
     ok(size == 32, "got %lu\n", size);
     ok(!memcmp(plaintext, expected3, sizeof(expected3)), "wrong data\n");
 
+    /* blocks are decrypted independently, also in place and across large buffers */
+    large = malloc(8192 + 64);
+    for (i = 0; i < 8192 + 64; i += 16) memcpy(large + i, ciphertext5, 16);
+    size = 0;
+    ret = BCryptDecrypt(key, large, 8192 + 64, NULL, NULL, 16, large, 8192 + 64, &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+    ok(size == 8192 + 64, "got %lu\n", size);
+    for (i = 0; i < 8192 + 64; i += 16)
+        if (memcmp(large + i, expected, 16)) break;
+    ok(i == 8192 + 64, "wrong data at %lu\n", i);
+    free(large);
+
     /* output size too small */
     size = 0;
     ret = BCryptDecrypt(key, ciphertext4, 32, NULL, NULL, 16, plaintext, 31, &size, 0);
@@ -311,9 +311,73 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
     return count;
 }
 
+/* Number of taps of a polyphase filter, padded so that the kernels can
+ * be processed four floats at a time. */
+static inline UINT fir_bank_taps(UINT firstep)
+{
+    return ((fir_len + firstep - 2) / firstep + 3) & ~3;
+}
+
+/**
+ * Polyphase filter banks, indexed by firstep.
+ *
+ * For each of the firstep phases a bank holds two rows of taps: the
+ * FIR sampled at that phase, and the difference to the next phase. The
+ * kernel for a fractional position is then row0 + rem * row1, which is
+ * what cp_fields_resample() used to gather from the FIR for every frame.
+ * Banks only depend on firstep, so they are shared by all buffers and
+ * never freed.
+ */
+static float * volatile fir_banks[128];
+
+static const float *get_fir_bank(UINT firstep)
+{
+    UINT taps = fir_bank_taps(firstep), phase, k;
+    float *bank, *row;
+
+    if (firstep >= ARRAY_SIZE(fir_banks)) return NULL;
+    if ((bank = fir_banks[firstep])) return bank;
+
+    if (!(bank = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, firstep * 2 * taps * sizeof(float))))
+        return NULL;
+
+    for (phase = 0, row = bank; phase < firstep; phase++, row += 2 * taps)
+    {
+        for (k = 0; phase + k * firstep < fir_len - 1; k++)
+        {
+            UINT idx = phase + k * firstep;
+            row[k] = fir[idx];
+            row[taps + k] = fir[idx + 1] - fir[idx];
+        }
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&fir_banks[firstep], bank, NULL))
+    {
+        HeapFree(GetProcessHeap(), 0, bank);
+        bank = fir_banks[firstep];
+    }
+    return bank;
+}
+
+static inline float dot_product(const float *a, const float *b, UINT len)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    UINT i;
+
+    /* independent partial sums let the compiler keep these in vector registers */
+    for (i = 0; i < len; i += 4)
+    {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+    return (sum0 + sum2) + (sum1 + sum3);
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
 {
-    UINT i, channel;
+    UINT i, j, channel;
     UINT istride = dsb->pwfx->nBlockAlign;
     UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
     UINT committed_samples = 0;
@@ -324,12 +388,13 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     UINT channels = dsb->mix_channels;
     UINT max_ipos = (freqAcc_start + count * dsb->freqAdjustNum) / dsb->freqAdjustDen;
 
-    UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
-    UINT required_input = max_ipos + fir_cachesize;
+    UINT fir_taps = fir_bank_taps(dsbfirstep);
+    UINT required_input = max_ipos + fir_taps;
+    const float *bank;
     float *intermediate, *fir_copy, *itmp;
 
     DWORD len = required_input * channels;
-    len += fir_cachesize;
+    len += fir_taps;
     len *= sizeof(float);
 
     *freqAccNum = freqAcc_end % dsb->freqAdjustDen;
@@ -337,6 +402,12 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     if (!secondarybuffer_is_audible(dsb))
         return max_ipos;
 
+    if (!(bank = get_fir_bank(dsbfirstep)))
+    {
+        ERR("No filter bank for firstep %u, not mixing.\n", dsbfirstep);
+        return max_ipos;
+    }
+
     if (!dsb->device->cp_buffer) {
         dsb->device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, len);
         dsb->device->cp_buffer_len = len;
@@ -346,7 +417,7 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     }
 
     fir_copy = dsb->device->cp_buffer;
-    intermediate = fir_copy + fir_cachesize;
+    intermediate = fir_copy + fir_taps;
 
     if(dsb->use_committed) {
         committed_samples = (dsb->writelead - dsb->committed_mixpos) / istride;
@@ -374,22 +445,15 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
         float rem = int_fir_steps + 1.0 - total_fir_steps;
+        const float *phase = bank + idx * 2 * fir_taps, *delta = phase + fir_taps;
 
-        int fir_used = 0;
-        while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
-        }
+        assert(ipos + fir_taps <= required_input);
 
-        assert(fir_used <= fir_cachesize);
-        assert(ipos + fir_used <= required_input);
+        for (j = 0; j < fir_taps; j++)
+            fir_copy[j] = phase[j] + delta[j] * rem;
 
         for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
+            float sum = dot_product(fir_copy, &intermediate[channel * required_input + ipos], fir_taps);
             dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
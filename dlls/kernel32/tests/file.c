@@ -1138,11 +1138,27 @@ static DWORD WINAPI copy_progress_cb(LARGE_INTEGER total_size, LARGE_INTEGER tot
     return PROGRESS_CANCEL;
 }
 
+static DWORD WINAPI copy_progress_count_cb(LARGE_INTEGER total_size, LARGE_INTEGER total_transferred,
+                                           LARGE_INTEGER stream_size, LARGE_INTEGER stream_transferred,
+                                           DWORD stream, DWORD reason, HANDLE source, HANDLE dest, LPVOID userdata)
+{
+    LONGLONG *transferred = userdata;
+
+    ok(total_size.QuadPart == 3 * 1024 * 1024 + 5, "got total size %s\n", wine_dbgstr_longlong(total_size.QuadPart));
+    ok(total_transferred.QuadPart >= *transferred, "transferred size went back from %s to %s\n",
+       wine_dbgstr_longlong(*transferred), wine_dbgstr_longlong(total_transferred.QuadPart));
+    if (reason == CALLBACK_STREAM_SWITCH)
+        ok(!total_transferred.QuadPart, "got transferred %s\n", wine_dbgstr_longlong(total_transferred.QuadPart));
+    *transferred = total_transferred.QuadPart;
+    return PROGRESS_CONTINUE;
+}
+
 static void test_CopyFileEx(void)
 {
     char temp_path[MAX_PATH];
-    char source[MAX_PATH], dest[MAX_PATH];
+    char source[MAX_PATH], dest[MAX_PATH], buffer[16];
     static const char prefix[] = "pfx";
+    LONGLONG transferred;
     HANDLE hfile;
     DWORD ret;
     BOOL retok;
@@ -1161,23 +1177,17 @@ static void test_CopyFileEx(void)
     ok(hfile != INVALID_HANDLE_VALUE, "failed to open destination file, error %ld\n", GetLastError());
     SetLastError(0xdeadbeef);
     retok = CopyFileExA(source, dest, copy_progress_cb, hfile, NULL, 0);
-    todo_wine
     ok(!retok, "CopyFileExA unexpectedly succeeded\n");
-    todo_wine
     ok(GetLastError() == ERROR_REQUEST_ABORTED, "expected ERROR_REQUEST_ABORTED, got %ld\n", GetLastError());
     ok(GetFileAttributesA(dest) != INVALID_FILE_ATTRIBUTES, "file was deleted\n");
 
     hfile = CreateFileA(dest, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_WRITE | FILE_SHARE_DELETE,
                         NULL, OPEN_EXISTING, 0, 0);
-    todo_wine
     ok(hfile != INVALID_HANDLE_VALUE, "failed to open destination file, error %ld\n", GetLastError());
     SetLastError(0xdeadbeef);
     retok = CopyFileExA(source, dest, copy_progress_cb, hfile, NULL, 0);
-    todo_wine
     ok(!retok, "CopyFileExA unexpectedly succeeded\n");
-    todo_wine
     ok(GetLastError() == ERROR_REQUEST_ABORTED, "expected ERROR_REQUEST_ABORTED, got %ld\n", GetLastError());
-    todo_wine
     ok(GetFileAttributesA(dest) == INVALID_FILE_ATTRIBUTES, "file was not deleted\n");
 
     retok = CopyFileExA(source, NULL, copy_progress_cb, hfile, NULL, 0);
@@ -1191,6 +1201,30 @@ static void test_CopyFileEx(void)
     ok(ret, "DeleteFileA failed with error %ld\n", GetLastError());
     ret = DeleteFileA(dest);
     ok(!ret, "DeleteFileA unexpectedly succeeded\n");
+
+    /* the progress routine gets called until the whole file is copied */
+    hfile = CreateFileA(source, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0);
+    ok(hfile != INVALID_HANDLE_VALUE, "failed to create source file, error %ld\n", GetLastError());
+    SetFilePointer(hfile, 3 * 1024 * 1024, NULL, FILE_BEGIN);
+    retok = WriteFile(hfile, "data", 5, &ret, NULL);
+    ok(retok, "WriteFile error %ld\n", GetLastError());
+    CloseHandle(hfile);
+
+    transferred = -1;
+    retok = CopyFileExA(source, dest, copy_progress_count_cb, &transferred, NULL, 0);
+    ok(retok, "CopyFileExA failed, error %ld\n", GetLastError());
+    ok(transferred == 3 * 1024 * 1024 + 5, "got transferred %s\n", wine_dbgstr_longlong(transferred));
+
+    hfile = CreateFileA(dest, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, 0);
+    ok(hfile != INVALID_HANDLE_VALUE, "failed to open destination file, error %ld\n", GetLastError());
+    ok(GetFileSize(hfile, NULL) == 3 * 1024 * 1024 + 5, "got size %lu\n", GetFileSize(hfile, NULL));
+    SetFilePointer(hfile, 3 * 1024 * 1024, NULL, FILE_BEGIN);
+    retok = ReadFile(hfile, buffer, sizeof(buffer), &ret, NULL);
+    ok(retok && ret == 5 && !strcmp(buffer, "data"), "got %lu bytes %s\n", ret, debugstr_a(buffer));
+    CloseHandle(hfile);
+
+    DeleteFileA(source);
+    DeleteFileA(dest);
 }
 
 /*
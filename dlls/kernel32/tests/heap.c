@@ -3730,6 +3730,127 @@ static void test_heap_sizes(void)
     test_heap_size( 0x150000 );
 }
 
+struct lfh_thread_params
+{
+    HANDLE heap;
+    BYTE seed;
+    BYTE *ptrs[0x800];
+};
+
+static SIZE_T lfh_block_size( UINT i )
+{
+    return 1 + (i * 7) % 0x200;
+}
+
+static void fill_lfh_blocks( struct lfh_thread_params *params )
+{
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(params->ptrs); i++)
+    {
+        params->ptrs[i] = HeapAlloc( params->heap, 0, lfh_block_size( i ) );
+        ok( !!params->ptrs[i], "HeapAlloc failed, error %lu\n", GetLastError() );
+        if (params->ptrs[i]) memset( params->ptrs[i], params->seed + i, lfh_block_size( i ) );
+    }
+}
+
+static DWORD WINAPI lfh_alloc_thread_proc( void *arg )
+{
+    fill_lfh_blocks( arg );
+    return 0;
+}
+
+static DWORD WINAPI lfh_realloc_thread_proc( void *arg )
+{
+    struct lfh_thread_params *params = arg;
+    BOOL ret;
+    UINT i;
+
+    /* free the blocks allocated by another thread, then allocate new ones */
+    for (i = 0; i < ARRAY_SIZE(params->ptrs); i++)
+    {
+        ret = HeapFree( params->heap, 0, params->ptrs[i] );
+        ok( ret, "HeapFree failed, error %lu\n", GetLastError() );
+    }
+    fill_lfh_blocks( params );
+    return 0;
+}
+
+static void run_lfh_threads( struct lfh_thread_params *params, UINT count, LPTHREAD_START_ROUTINE proc )
+{
+    HANDLE threads[4];
+    DWORD res;
+    UINT i;
+
+    for (i = 0; i < count; i++)
+    {
+        threads[i] = CreateThread( NULL, 0, proc, params + i, 0, NULL );
+        ok( !!threads[i], "CreateThread failed, error %lu\n", GetLastError() );
+    }
+    res = WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+    ok( !res, "WaitForMultipleObjects returned %#lx, error %lu\n", res, GetLastError() );
+    for (i = 0; i < count; i++) CloseHandle( threads[i] );
+}
+
+static void check_lfh_blocks( struct lfh_thread_params *params, UINT count )
+{
+    UINT i, j, k;
+    SIZE_T size;
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(params[i].ptrs); j++)
+        {
+            BYTE *ptr = params[i].ptrs[j], expect = params[i].seed + j;
+
+            size = HeapSize( params[i].heap, 0, ptr );
+            ok( size == lfh_block_size( j ), "got size %#Ix\n", size );
+            for (k = 0; k < lfh_block_size( j ); k++) if (ptr[k] != expect) break;
+            ok( k == lfh_block_size( j ), "thread %u block %u overwritten at %u\n", i, j, k );
+        }
+    }
+}
+
+static void test_heap_threads(void)
+{
+    struct lfh_thread_params *params;
+    UINT i, j, count = 4;
+    BYTE *ptr;
+    BOOL ret;
+
+    params = calloc( count, sizeof(*params) );
+    for (i = 0; i < count; i++)
+    {
+        params[i].heap = GetProcessHeap();
+        params[i].seed = 0x11 * (i + 1);
+    }
+
+    run_lfh_threads( params, count, lfh_alloc_thread_proc );
+    check_lfh_blocks( params, count );
+
+    /* swap the block arrays, so that each thread frees blocks allocated by another thread */
+    for (j = 0; j < ARRAY_SIZE(params->ptrs); j++)
+    {
+        ptr = params[0].ptrs[j];
+        for (i = 0; i < count - 1; i++) params[i].ptrs[j] = params[i + 1].ptrs[j];
+        params[count - 1].ptrs[j] = ptr;
+    }
+
+    run_lfh_threads( params, count, lfh_realloc_thread_proc );
+    check_lfh_blocks( params, count );
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(params[i].ptrs); j++)
+        {
+            ret = HeapFree( params[i].heap, 0, params[i].ptrs[j] );
+            ok( ret, "HeapFree failed, error %lu\n", GetLastError() );
+        }
+    }
+
+    free( params );
+}
+
 START_TEST(heap)
 {
     int argc;
@@ -3745,6 +3866,7 @@ START_TEST(heap)
     }
 
     test_HeapCreate();
+    test_heap_threads();
     test_GlobalAlloc();
     test_LocalAlloc();
 
@@ -453,6 +453,12 @@ static void test_VirtualAlloc(void)
     ok(GetLastError() == ERROR_INVALID_PARAMETER, "got %ld, expected ERROR_INVALID_PARAMETER\n", GetLastError());
 
     ok(VirtualFree(addr1, 0, MEM_RELEASE), "VirtualFree failed\n");
+
+    /* large pages require SeLockMemoryPrivilege, which is disabled by default */
+    SetLastError(0xdeadbeef);
+    addr1 = VirtualAlloc(NULL, GetLargePageMinimum(), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(!addr1, "VirtualAlloc unexpectedly succeeded\n");
+    ok(GetLastError() == ERROR_PRIVILEGE_NOT_HELD, "got %ld, expected ERROR_PRIVILEGE_NOT_HELD\n", GetLastError());
 }
 
 static void test_MapViewOfFile(void)
@@ -42,6 +42,7 @@
 
 #include "kernelbase.h"
 #include "wine/exception.h"
+#include "wine/fsctl.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(file);
@@ -493,30 +494,68 @@ BOOL WINAPI DECLSPEC_HOTPATCH AreFileApisANSI(void)
 }
 
 
+/* call the progress routine of CopyFileEx, return FALSE if the copy must be aborted */
+static BOOL copy_file_progress( LPPROGRESS_ROUTINE *progress, void *param, BOOL *cancel_ptr,
+                                LONGLONG total, LONGLONG transferred, DWORD reason,
+                                HANDLE h1, HANDLE h2, BOOL *delete )
+{
+    LARGE_INTEGER size, done;
+    DWORD ret;
+
+    if (cancel_ptr && *cancel_ptr)
+    {
+        *delete = TRUE;
+        SetLastError( ERROR_REQUEST_ABORTED );
+        return FALSE;
+    }
+    if (!*progress) return TRUE;
+
+    size.QuadPart = total;
+    done.QuadPart = transferred;
+    switch ((ret = (*progress)( size, done, size, done, 1, reason, h1, h2, param )))
+    {
+    case PROGRESS_CONTINUE:
+        return TRUE;
+    case PROGRESS_QUIET:
+        *progress = NULL;
+        return TRUE;
+    case PROGRESS_CANCEL:
+        *delete = TRUE;
+        /* fall through */
+    case PROGRESS_STOP:
+        SetLastError( ERROR_REQUEST_ABORTED );
+        return FALSE;
+    default:
+        FIXME( "unknown progress return %lu\n", ret );
+        return TRUE;
+    }
+}
+
+
 /***********************************************************************
  *	CopyFileExW   (kernelbase.@)
  */
 BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUTINE progress,
                          void *param, BOOL *cancel_ptr, DWORD flags )
 {
-    static const int buffer_size = 65536;
+    static const int buffer_size = 1024 * 1024;
+    static const LONGLONG chunk_size = 64 * 1024 * 1024;
     HANDLE h1, h2;
     FILE_BASIC_INFORMATION info;
+    FILE_STANDARD_INFORMATION std_info;
+    DUPLICATE_EXTENTS_DATA extents;
     IO_STATUS_BLOCK io;
+    LONGLONG transferred = 0;
+    LARGE_INTEGER pos;
     DWORD count;
-    BOOL ret = FALSE;
-    char *buffer;
+    BOOL ret = FALSE, delete = FALSE, can_delete;
+    char *buffer = NULL;
 
     if (!source || !dest)
     {
         SetLastError( ERROR_INVALID_PARAMETER );
         return FALSE;
     }
-    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
-    {
-        SetLastError( ERROR_NOT_ENOUGH_MEMORY );
-        return FALSE;
-    }
 
     TRACE("%s -> %s, %lx\n", debugstr_w(source), debugstr_w(dest), flags);
 
@@ -531,14 +570,13 @@ BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUT
                            NULL, OPEN_EXISTING, 0, 0 )) == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open source %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         return FALSE;
     }
 
-    if (!set_ntstatus( NtQueryInformationFile( h1, &io, &info, sizeof(info), FileBasicInformation )))
+    if (!set_ntstatus( NtQueryInformationFile( h1, &io, &info, sizeof(info), FileBasicInformation )) ||
+        !set_ntstatus( NtQueryInformationFile( h1, &io, &std_info, sizeof(std_info), FileStandardInformation )))
     {
         WARN("GetFileInformationByHandle returned error for %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
@@ -554,32 +592,78 @@ BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUT
         }
         if (same_file)
         {
-            HeapFree( GetProcessHeap(), 0, buffer );
             CloseHandle( h1 );
             SetLastError( ERROR_SHARING_VIOLATION );
             return FALSE;
         }
     }
 
+    /* a cancelled copy is deleted, unless the destination is already opened without delete sharing */
+    if ((h2 = CreateFileW( dest, DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                           OPEN_EXISTING, 0, 0 )) != INVALID_HANDLE_VALUE)
+    {
+        can_delete = TRUE;
+        CloseHandle( h2 );
+    }
+    else can_delete = (GetLastError() == ERROR_FILE_NOT_FOUND);
+
     if ((h2 = CreateFileW( dest, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
                            (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
                            info.FileAttributes, h1 )) == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open dest %s\n", debugstr_w(dest));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
 
-    while (ReadFile( h1, buffer, buffer_size, &count, NULL ) && count)
+    if (!copy_file_progress( &progress, param, cancel_ptr, std_info.EndOfFile.QuadPart, 0,
+                             CALLBACK_STREAM_SWITCH, h1, h2, &delete ))
+        goto done;
+
+    /* let the file system copy the data, or share its extents, when it can */
+    extents.FileHandle = h1;
+    while (transferred < std_info.EndOfFile.QuadPart)
+    {
+        extents.SourceFileOffset.QuadPart = transferred;
+        extents.TargetFileOffset.QuadPart = transferred;
+        extents.ByteCount.QuadPart = min( chunk_size, std_info.EndOfFile.QuadPart - transferred );
+        if (NtFsControlFile( h2, NULL, NULL, NULL, &io, FSCTL_WINE_COPY_FILE_RANGE,
+                             &extents, sizeof(extents), NULL, 0 ))
+            break;
+        transferred += io.Information;
+        if (!copy_file_progress( &progress, param, cancel_ptr, std_info.EndOfFile.QuadPart, transferred,
+                                 CALLBACK_CHUNK_FINISHED, h1, h2, &delete ))
+            goto done;
+        /* the source got shorter, let the loop below find its end */
+        if (io.Information < extents.ByteCount.QuadPart) break;
+    }
+
+    /* fall back to reading and writing; files without a known size are read too */
+    if (transferred < std_info.EndOfFile.QuadPart || !transferred)
     {
-        char *p = buffer;
-        while (count != 0)
+        if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
         {
-            DWORD res;
-            if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
-            p += res;
-            count -= res;
+            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+            goto done;
+        }
+        pos.QuadPart = transferred;
+        if (!SetFilePointerEx( h1, pos, NULL, FILE_BEGIN ) || !SetFilePointerEx( h2, pos, NULL, FILE_BEGIN ))
+            goto done;
+
+        while (ReadFile( h1, buffer, buffer_size, &count, NULL ) && count)
+        {
+            char *p = buffer;
+            while (count != 0)
+            {
+                DWORD res;
+                if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
+                p += res;
+                count -= res;
+                transferred += res;
+            }
+            if (!copy_file_progress( &progress, param, cancel_ptr, std_info.EndOfFile.QuadPart, transferred,
+                                     CALLBACK_CHUNK_FINISHED, h1, h2, &delete ))
+                goto done;
         }
     }
     ret =  TRUE;
@@ -590,6 +674,12 @@ done:
     HeapFree( GetProcessHeap(), 0, buffer );
     CloseHandle( h1 );
     CloseHandle( h2 );
+    if (delete && can_delete)
+    {
+        DWORD err = GetLastError();
+        DeleteFileW( dest );
+        SetLastError( err );
+    }
     if (ret) SetLastError( 0 );
     return ret;
 }
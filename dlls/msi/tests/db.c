@@ -1350,7 +1350,7 @@ static void test_viewgetcolumninfo(void)
 
     r = run_query( hdb, 0,
             "CREATE TABLE `UIText` "
-            "( `Key` CHAR(72) NOT NULL, `Text` CHAR(255) LOCALIZABLE PRIMARY KEY `Key`)" );
+            "( `Num` CHAR(72) NOT NULL, `Text` CHAR(255) LOCALIZABLE PRIMARY KEY `Num`)" );
     ok( r == ERROR_SUCCESS , "Failed to create table\n" );
 
     ok( 0x2d48 == get_columns_table_type(hdb, "UIText", 1 ), "_columns table wrong\n");
@@ -3411,6 +3411,49 @@ static const char *join_res_ninth[][6] =
     { "1", "2", "5", "6", "11", "12" },
 };
 
+/* check the rows of a two-column query, in any order; each row is given as "field1|field2" */
+static void WINAPIV check_join_rows_(int line, MSIHANDLE hdb, const char *query, UINT count, ...)
+{
+    const char *expect[8];
+    MSIHANDLE hview, hrec;
+    UINT r, i, found = 0;
+    va_list args;
+
+    va_start(args, count);
+    for (i = 0; i < count; ++i) expect[i] = va_arg(args, const char *);
+    va_end(args);
+
+    r = MsiDatabaseOpenViewA(hdb, query, &hview);
+    ok_(__FILE__, line)(r == ERROR_SUCCESS, "failed to open view: %u\n", r);
+    r = MsiViewExecute(hview, 0);
+    ok_(__FILE__, line)(r == ERROR_SUCCESS, "failed to execute view: %u\n", r);
+
+    while (!(r = MsiViewFetch(hview, &hrec)))
+    {
+        char row[200], buffer[100];
+        DWORD sz = sizeof(row);
+
+        MsiRecordGetStringA(hrec, 1, row, &sz);
+        sz = sizeof(buffer);
+        MsiRecordGetStringA(hrec, 2, buffer, &sz);
+        strcat(row, "|");
+        strcat(row, buffer);
+        MsiCloseHandle(hrec);
+
+        for (i = 0; i < count; ++i)
+            if (!(found & (1 << i)) && !strcmp(row, expect[i])) break;
+        ok_(__FILE__, line)(i < count, "unexpected row %s\n", row);
+        found |= 1 << i;
+    }
+    ok_(__FILE__, line)(r == ERROR_NO_MORE_ITEMS, "failed to fetch view: %u\n", r);
+    for (i = 0; i < count; ++i)
+        ok_(__FILE__, line)(found & (1 << i), "missing row %s\n", expect[i]);
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+}
+#define check_join_rows(hdb, query, ...) check_join_rows_(__LINE__, hdb, query, __VA_ARGS__)
+
 static void test_join(void)
 {
     MSIHANDLE hdb, hview, hrec;
@@ -3743,6 +3786,77 @@ static void test_join(void)
     MsiViewClose(hview);
     MsiCloseHandle(hview);
 
+    query = "SELECT * FROM `One`, `Two`, `Three` "
+            "WHERE `Three`.`E` = 11 AND `Two`.`C` = 5";
+    r = MsiDatabaseOpenViewA(hdb, query, &hview);
+    ok( r == ERROR_SUCCESS, "failed to open view: %d\n", r );
+
+    r = MsiViewExecute(hview, 0);
+    ok( r == ERROR_SUCCESS, "failed to execute view: %d\n", r );
+
+    r = MsiViewFetch(hview, &hrec);
+    ok( r == ERROR_SUCCESS, "failed to fetch view: %d\n", r );
+    check_record(hrec, 6, "1", "2", "5", "6", "11", "12");
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok( r == ERROR_NO_MORE_ITEMS, "expected no more items: %d\n", r );
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
+    /* equality joins on integer and string columns, alone and chained */
+    query = "CREATE TABLE `Parent` (`Id` SHORT, `Name` CHAR(32) PRIMARY KEY `Id`)";
+    r = run_query( hdb, 0, query );
+    ok( r == ERROR_SUCCESS, "cannot create table: %d\n", r );
+    query = "CREATE TABLE `Child` (`Num` SHORT, `Parent_` SHORT, `Tag` CHAR(32) PRIMARY KEY `Num`)";
+    r = run_query( hdb, 0, query );
+    ok( r == ERROR_SUCCESS, "cannot create table: %d\n", r );
+    query = "CREATE TABLE `Color` (`Name` CHAR(32), `Value` SHORT PRIMARY KEY `Name`)";
+    r = run_query( hdb, 0, query );
+    ok( r == ERROR_SUCCESS, "cannot create table: %d\n", r );
+
+    r = run_query( hdb, 0, "INSERT INTO `Parent` (`Id`, `Name`) VALUES (1, 'alpha')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` (`Id`, `Name`) VALUES (2, 'beta')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` (`Id`, `Name`) VALUES (3, 'gamma')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Child` (`Num`, `Parent_`, `Tag`) VALUES (10, 1, 'red')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Child` (`Num`, `Parent_`, `Tag`) VALUES (11, 2, 'green')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Child` (`Num`, `Parent_`, `Tag`) VALUES (12, 2, 'blue')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Child` (`Num`, `Parent_`, `Tag`) VALUES (13, 4, 'red')" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Color` (`Name`, `Value`) VALUES ('red', 100)" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Color` (`Name`, `Value`) VALUES ('blue', 300)" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Color` (`Name`, `Value`) VALUES ('white', 400)" );
+    ok( r == ERROR_SUCCESS, "cannot insert into table: %d\n", r );
+
+    check_join_rows( hdb, "SELECT `Parent`.`Name`, `Child`.`Num` FROM `Parent`, `Child` "
+                     "WHERE `Parent`.`Id` = `Child`.`Parent_`",
+                     3, "alpha|10", "beta|11", "beta|12" );
+    check_join_rows( hdb, "SELECT `Parent`.`Name`, `Child`.`Num` FROM `Child`, `Parent` "
+                     "WHERE `Child`.`Parent_` = `Parent`.`Id` AND `Parent`.`Id` = 2",
+                     2, "beta|11", "beta|12" );
+    check_join_rows( hdb, "SELECT `Child`.`Num`, `Color`.`Value` FROM `Child`, `Color` "
+                     "WHERE `Child`.`Tag` = `Color`.`Name`",
+                     3, "10|100", "12|300", "13|100" );
+    check_join_rows( hdb, "SELECT `Parent`.`Name`, `Color`.`Value` FROM `Parent`, `Child`, `Color` "
+                     "WHERE `Parent`.`Id` = `Child`.`Parent_` AND `Child`.`Tag` = `Color`.`Name`",
+                     2, "alpha|100", "beta|300" );
+    check_join_rows( hdb, "SELECT `Parent`.`Name`, `Color`.`Value` FROM `Color`, `Parent`, `Child` "
+                     "WHERE `Color`.`Name` = `Child`.`Tag` AND `Child`.`Parent_` = `Parent`.`Id`",
+                     2, "alpha|100", "beta|300" );
+    check_join_rows( hdb, "SELECT `Parent`.`Name`, `Color`.`Value` FROM `Parent`, `Child`, `Color` "
+                     "WHERE `Parent`.`Id` = `Child`.`Parent_` AND `Child`.`Tag` = `Color`.`Name` "
+                     "AND `Color`.`Value` = 300",
+                     1, "beta|300" );
+
     query = "SELECT * FROM `Four`, `Five`";
     r = MsiDatabaseOpenViewA(hdb, query, &hview);
     ok( r == ERROR_SUCCESS, "failed to open view: %d\n", r );
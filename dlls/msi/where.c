@@ -51,6 +51,10 @@ typedef struct tagJOINTABLE
     UINT col_count;
     UINT row_count;
     UINT table_index;
+    struct expr *index_column; /* column of this table compared for equality */
+    struct expr *index_probe;  /* value it is compared to, known when this table is scanned */
+    UINT *index_buckets;       /* first row + 1 for each hash bucket */
+    UINT *index_chain;         /* next row + 1 with the same hash */
 } JOINTABLE;
 
 typedef struct tagMSIORDERINFO
@@ -647,16 +651,54 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static UINT get_index_key( MSIWHEREVIEW *wv, struct expr *expr, const UINT rows[], UINT *key )
+{
+    const WCHAR *str;
+    UINT r, id;
+    INT val;
+
+    switch (expr->type)
+    {
+    case EXPR_COL_NUMBER_STRING:
+        /* same lookup as STRING_evaluate, NULL and empty strings hash the same */
+        if (expr_fetch_value( &expr->u.column, rows, &id ) == ERROR_SUCCESS)
+            str = msi_string_lookup( wv->db->strings, id, NULL );
+        else
+            str = NULL;
+        break;
+
+    case EXPR_SVAL:
+        str = expr->u.sval;
+        break;
+
+    default:
+        if ((r = WHERE_evaluate( wv, rows, expr, &val, NULL )) != ERROR_SUCCESS)
+            return r;
+        *key = val;
+        return ERROR_SUCCESS;
+    }
+
+    *key = 0;
+    if (str) while (*str) *key = *key * 31 + *str++;
+    return ERROR_SUCCESS;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    JOINTABLE *table = *tables;
+    UINT r = ERROR_SUCCESS, row, key;
+    BOOL use_index = FALSE;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    /* only visit the rows that can match the equality the table is indexed on */
+    if (table->index_buckets && get_index_key( wv, table->index_probe, table_rows, &key ) == ERROR_SUCCESS)
+        use_index = TRUE;
+
+    for (row = use_index ? table->index_buckets[key % table->row_count] : 1; row;
+         row = use_index ? table->index_chain[row - 1] : (row < table->row_count ? row + 1 : 0))
     {
+        table_rows[table->table_index] = row - 1;
         val = 0;
         wv->rec_index = 0;
         r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
@@ -678,7 +720,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
             }
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    table_rows[table->table_index] = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -786,6 +828,71 @@ static UINT reorder_check( const struct expr *expr, JOINTABLE **ordered_tables,
     }
 }
 
+static BOOL is_index_column( const struct expr *expr, const JOINTABLE *table, BOOL string )
+{
+    if (string && expr->type != EXPR_COL_NUMBER_STRING) return FALSE;
+    if (!string && expr->type != EXPR_COL_NUMBER && expr->type != EXPR_COL_NUMBER32) return FALSE;
+    return expr->u.column.parsed.table == table;
+}
+
+static BOOL is_index_probe( const struct expr *expr, JOINTABLE **ordered_tables,
+                            const JOINTABLE *table, BOOL string )
+{
+    switch (expr->type)
+    {
+    case EXPR_UVAL:
+        return !string;
+    case EXPR_SVAL:
+        return string;
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+        if (string) return FALSE;
+        break;
+    case EXPR_COL_NUMBER_STRING:
+        if (!string) return FALSE;
+        break;
+    default:
+        return FALSE;
+    }
+
+    /* the other column must belong to a table iterated in an outer loop */
+    for (; *ordered_tables && *ordered_tables != table; ordered_tables++)
+        if (*ordered_tables == expr->u.column.parsed.table) return TRUE;
+    return FALSE;
+}
+
+/* finds an equality in the top level conjunction that restricts the rows of the table */
+static BOOL find_index_expr( struct expr *cond, JOINTABLE **ordered_tables, JOINTABLE *table )
+{
+    struct expr *left, *right;
+    BOOL string;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+        return find_index_expr( cond->u.expr.left, ordered_tables, table ) ||
+               find_index_expr( cond->u.expr.right, ordered_tables, table );
+
+    if (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP) return FALSE;
+    if (cond->u.expr.op != OP_EQ) return FALSE;
+
+    string = cond->type == EXPR_STRCMP;
+    left = cond->u.expr.left;
+    right = cond->u.expr.right;
+
+    if (is_index_column( left, table, string ) && is_index_probe( right, ordered_tables, table, string ))
+    {
+        table->index_column = left;
+        table->index_probe = right;
+        return TRUE;
+    }
+    if (is_index_column( right, table, string ) && is_index_probe( left, ordered_tables, table, string ))
+    {
+        table->index_column = right;
+        table->index_probe = left;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /* reorders the tablelist in a way to evaluate the condition as fast as possible */
 static JOINTABLE **ordertables( MSIWHEREVIEW *wv )
 {
@@ -802,15 +909,72 @@ static JOINTABLE **ordertables( MSIWHEREVIEW *wv )
         reorder_check(wv->cond, tables, TRUE, &table);
     }
 
-    table = wv->tables;
-    while (table)
+    /* then prefer tables that can be looked up through an equality with the ones
+     * already ordered, so that they can use a join index */
+    for (;;)
     {
-        add_to_array(tables, table);
-        table = table->next;
+        JOINTABLE *next = NULL;
+
+        for (table = wv->tables; table; table = table->next)
+        {
+            if (in_array(tables, table))
+                continue;
+            if (!next)
+                next = table;
+            if (wv->cond && find_index_expr(wv->cond, tables, table))
+            {
+                next = table;
+                break;
+            }
+        }
+        if (!next)
+            break;
+        add_to_array(tables, next);
     }
     return tables;
 }
 
+static void free_join_index( JOINTABLE *table )
+{
+    free( table->index_buckets );
+    free( table->index_chain );
+    table->index_buckets = NULL;
+    table->index_chain = NULL;
+}
+
+/* hashes the rows of an inner join table so that check_condition doesn't need to
+ * scan all of them for every combination of rows of the outer tables */
+static void build_join_index( MSIWHEREVIEW *wv, JOINTABLE **ordered_tables, JOINTABLE *table, UINT rows[] )
+{
+    UINT i, key;
+
+    if (!find_index_expr( wv->cond, ordered_tables, table )) return;
+
+    table->index_buckets = calloc( table->row_count, sizeof(*table->index_buckets) );
+    table->index_chain = malloc( table->row_count * sizeof(*table->index_chain) );
+    if (!table->index_buckets || !table->index_chain)
+    {
+        free_join_index( table );
+        return;
+    }
+
+    /* insert in reverse so that each chain lists rows in ascending order */
+    for (i = table->row_count; i > 0; i--)
+    {
+        rows[table->table_index] = i - 1;
+        if (get_index_key( wv, table->index_column, rows, &key ) != ERROR_SUCCESS)
+        {
+            free_join_index( table );
+            break;
+        }
+        table->index_chain[i - 1] = table->index_buckets[key % table->row_count];
+        table->index_buckets[key % table->row_count] = i;
+    }
+    rows[table->table_index] = INVALID_ROW_INDEX;
+
+    if (table->index_buckets) TRACE("using index for table %u\n", table->table_index);
+}
+
 static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 {
     MSIWHEREVIEW *wv = (MSIWHEREVIEW*)view;
@@ -852,8 +1016,17 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
+    if (wv->cond)
+    {
+        for (i = 1; i < wv->table_count; i++)
+            build_join_index(wv, ordered_tables, ordered_tables[i], rows);
+    }
+
     r =  check_condition(wv, record, ordered_tables, rows);
 
+    for (i = 0; i < wv->table_count; i++)
+        free_join_index(ordered_tables[i]);
+
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
 
@@ -1250,7 +1423,7 @@ UINT WHERE_CreateView( MSIDATABASE *db, MSIVIEW **view, LPWSTR tables,
         if ((ptr = wcschr(tables, ' ')))
             *ptr = '\0';
 
-        table = malloc(sizeof(JOINTABLE));
+        table = calloc(1, sizeof(JOINTABLE));
         if (!table)
         {
             r = ERROR_OUTOFMEMORY;
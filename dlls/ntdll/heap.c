@@ -1805,6 +1805,24 @@ static inline struct block *group_find_free_block( struct group *group, SIZE_T b
     return group_get_block( group, block_size, i );
 }
 
+/* lookup up to count free blocks using the group free_bits, the current thread must own the group */
+static inline UINT group_find_free_blocks( struct group *group, SIZE_T block_size, struct block **blocks, UINT count )
+{
+    ULONG i, free_bits = ReadNoFence( &group->free_bits ), used_bits = 0;
+    UINT found = 0;
+
+    /* other threads may only set free bits, so the ones we see will stay set */
+    while (free_bits && found < count)
+    {
+        BitScanForward( &i, free_bits );
+        free_bits &= ~(1 << i);
+        used_bits |= 1 << i;
+        blocks[found++] = group_get_block( group, block_size, i );
+    }
+    InterlockedAnd( &group->free_bits, ~used_bits );
+    return found;
+}
+
 /* allocate a new group block using non-LFH allocation, returns a group owned by current thread */
 static struct group *group_allocate( struct heap *heap, ULONG flags, SIZE_T block_size )
 {
@@ -1914,19 +1932,26 @@ static NTSTATUS heap_release_bin_group( struct heap *heap, ULONG flags, struct b
     return group_release( heap, flags, bin, group );
 }
 
-static struct block *find_free_bin_block( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin )
+/* lookup up to count free blocks in a bin, returns the number of blocks found */
+static UINT find_free_bin_blocks( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin,
+                                  struct block **blocks, UINT count )
 {
     ULONG affinity = heap_current_thread_affinity();
-    struct block *block;
     struct group *group;
+    UINT found;
 
     /* acquire a group, the thread will own it and no other thread can clear free bits.
      * some other thread might still set the free bits if they are freeing blocks.
      */
-    if (!(group = heap_acquire_bin_group( heap, flags, block_size, bin ))) return NULL;
+    if (!(group = heap_acquire_bin_group( heap, flags, block_size, bin ))) return 0;
     group->affinity = affinity;
 
-    block = group_find_free_block( group, block_size );
+    if (count == 1)
+    {
+        blocks[0] = group_find_free_block( group, block_size );
+        found = 1;
+    }
+    else found = group_find_free_blocks( group, block_size, blocks, count );
 
     /* serialize with heap_free_block_lfh: atomically set GROUP_FLAG_FREE when the free bits are all 0. */
     if (ReadNoFence( &group->free_bits ) || InterlockedCompareExchange( &group->free_bits, GROUP_FLAG_FREE, 0 ))
@@ -1936,7 +1961,72 @@ static struct block *find_free_bin_block( struct heap *heap, ULONG flags, SIZE_T
             RtlInterlockedPushEntrySList( &bin->groups, &group->entry );
     }
 
-    return block;
+    return found;
+}
+
+/* Per-thread cache of free LFH blocks, for the smaller bins of the process heap.
+ *
+ * Cached blocks are marked free but their group free bits are kept cleared, so that
+ * allocating or freeing them doesn't need any atomic operation. The cache is refilled
+ * and flushed in batches, and released when the thread exits.
+ */
+
+#define THREAD_CACHE_BIN_COUNT  BLOCK_SIZE_BIN( BIN_SIZE_MIN_2 + 1 )
+#define THREAD_CACHE_DEPTH      16
+
+#define THREAD_CACHE_SKIP_FLAGS (HEAP_CHECKING_ENABLED | HEAP_VALIDATE | HEAP_VALIDATE_ALL | HEAP_VALIDATE_PARAMS)
+
+struct thread_cache_bin
+{
+    UINT          count;
+    struct block *blocks[THREAD_CACHE_DEPTH];
+};
+
+struct thread_cache
+{
+    struct thread_cache_bin bins[THREAD_CACHE_BIN_COUNT];
+};
+
+static inline struct thread_cache **thread_cache_ptr(void)
+{
+    return (struct thread_cache **)&NtCurrentTeb()->ReservedForPerf;
+}
+
+static struct thread_cache *heap_alloc_thread_cache( struct heap *heap )
+{
+    ULONG flags = heap_get_flags( heap, HEAP_ZERO_MEMORY );
+    SIZE_T size = sizeof(struct thread_cache), block_size = heap_get_block_size( heap, flags, size );
+    struct thread_cache *cache;
+
+    heap_lock( heap, flags );
+    if (heap_allocate_block( heap, flags, block_size, size, (void **)&cache )) cache = NULL;
+    heap_unlock( heap, flags );
+
+    return *thread_cache_ptr() = cache;
+}
+
+static inline struct thread_cache_bin *heap_get_thread_cache_bin( struct heap *heap, ULONG flags,
+                                                                  struct bin *bin, BOOL create )
+{
+    struct thread_cache *cache;
+
+    if (heap != process_heap || heap->pending_free || (flags & THREAD_CACHE_SKIP_FLAGS)) return NULL;
+    if (bin - heap->bins >= THREAD_CACHE_BIN_COUNT) return NULL;
+    if (!(cache = *thread_cache_ptr()) && (!create || !(cache = heap_alloc_thread_cache( heap )))) return NULL;
+    return cache->bins + (bin - heap->bins);
+}
+
+static struct block *find_free_cached_block( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin )
+{
+    struct thread_cache_bin *cache;
+    struct block *block;
+
+    if (!(cache = heap_get_thread_cache_bin( heap, flags, bin, TRUE )))
+        return find_free_bin_blocks( heap, flags, block_size, bin, &block, 1 ) ? block : NULL;
+
+    if (!cache->count)
+        cache->count = find_free_bin_blocks( heap, flags, block_size, bin, cache->blocks, THREAD_CACHE_DEPTH / 2 );
+    return cache->count ? cache->blocks[--cache->count] : NULL;
 }
 
 static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T block_size,
@@ -1953,7 +2043,7 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
 
     block_size = BLOCK_BIN_SIZE( BLOCK_SIZE_BIN( block_size ) );
 
-    if ((block = find_free_bin_block( heap, flags, block_size, bin )))
+    if ((block = find_free_cached_block( heap, flags, block_size, bin )))
     {
         block_set_type( block, BLOCK_TYPE_USED );
         block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_USER_FLAGS( flags ) );
@@ -1966,33 +2056,53 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
     return block ? STATUS_SUCCESS : STATUS_NO_MEMORY;
 }
 
+/* return a block, already marked as free, to its group */
+static NTSTATUS bin_free_block( struct heap *heap, ULONG flags, struct bin *bin, struct block *block )
+{
+    struct group *group = block_get_group( block );
+    SIZE_T i = block_get_group_index( block );
+    NTSTATUS status = STATUS_SUCCESS;
+
+    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
+    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
+    {
+        /* thread now owns the group, and can release it to its bin */
+        group->free_bits = ~GROUP_FLAG_FREE;
+        status = heap_release_bin_group( heap, flags, bin, group );
+    }
+
+    return status;
+}
+
 static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block )
 {
     struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
     SIZE_T i, block_size = block_get_size( block );
-    struct group *group = block_get_group( block );
-    NTSTATUS status = STATUS_SUCCESS;
+    struct thread_cache_bin *cache;
 
     if (!(block_get_flags( block ) & BLOCK_FLAG_LFH)) return STATUS_UNSUCCESSFUL;
 
     bin = heap->bins + BLOCK_SIZE_BIN( block_size );
     if (bin == last) return STATUS_UNSUCCESSFUL;
 
-    i = block_get_group_index( block );
     valgrind_make_writable( block, sizeof(*block) );
     block_set_type( block, BLOCK_TYPE_FREE );
     block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_FLAG_FREE );
     mark_block_free( block + 1, (char *)block + block_size - (char *)(block + 1), flags );
 
-    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
-    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
+    if (!(cache = heap_get_thread_cache_bin( heap, flags, bin, FALSE )))
+        return bin_free_block( heap, flags, bin, block );
+
+    if (cache->count == THREAD_CACHE_DEPTH)
     {
-        /* thread now owns the group, and can release it to its bin */
-        group->free_bits = ~GROUP_FLAG_FREE;
-        status = heap_release_bin_group( heap, flags, bin, group );
+        /* flush the least recently freed half of the cache */
+        for (i = 0; i < THREAD_CACHE_DEPTH / 2; i++) bin_free_block( heap, flags, bin, cache->blocks[i] );
+        memmove( cache->blocks, cache->blocks + THREAD_CACHE_DEPTH / 2,
+                 (THREAD_CACHE_DEPTH / 2) * sizeof(*cache->blocks) );
+        cache->count -= THREAD_CACHE_DEPTH / 2;
     }
-
-    return status;
+    cache->blocks[cache->count++] = block;
+    return STATUS_SUCCESS;
 }
 
 static void bin_try_enable( struct heap *heap, struct bin *bin )
@@ -2039,12 +2149,31 @@ static void heap_thread_detach_bin_groups( struct heap *heap )
     }
 }
 
+static void heap_thread_detach_cache( struct heap *heap )
+{
+    struct thread_cache *cache;
+    UINT i, j;
+
+    if (!(cache = *thread_cache_ptr())) return;
+    *thread_cache_ptr() = NULL;
+
+    for (i = 0; i < THREAD_CACHE_BIN_COUNT; ++i)
+    {
+        struct thread_cache_bin *bin = cache->bins + i;
+        for (j = 0; j < bin->count; ++j) bin_free_block( heap, heap->flags, heap->bins + i, bin->blocks[j] );
+    }
+
+    heap_free_block( heap, heap->flags, (struct block *)cache - 1 );
+}
+
 void heap_thread_detach(void)
 {
     struct heap *heap;
 
     RtlEnterCriticalSection( &process_heap->cs );
 
+    heap_thread_detach_cache( process_heap );
+
     LIST_FOR_EACH_ENTRY( heap, &process_heap->entry, struct heap, entry )
         heap_thread_detach_bin_groups( heap );
 
@@ -4185,6 +4185,125 @@ static void test_dotfile_file_attributes(void)
     CloseHandle( h );
 }
 
+static void set_directory_age( const char *name, unsigned int hours )
+{
+    ULARGE_INTEGER time;
+    FILETIME ft;
+    HANDLE h;
+    BOOL ret;
+
+    GetSystemTimeAsFileTime( &ft );
+    time.u.LowPart = ft.dwLowDateTime;
+    time.u.HighPart = ft.dwHighDateTime;
+    time.QuadPart -= hours * (ULONGLONG)36000000000;
+    ft.dwLowDateTime = time.u.LowPart;
+    ft.dwHighDateTime = time.u.HighPart;
+
+    h = CreateFileA( name, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                     NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0 );
+    ok( h != INVALID_HANDLE_VALUE, "failed to open %s, error %lu\n", name, GetLastError() );
+    ret = SetFileTime( h, NULL, NULL, &ft );
+    ok( ret, "SetFileTime failed %lu\n", GetLastError() );
+    CloseHandle( h );
+}
+
+static void test_large_directory_case(void)
+{
+    char temppath[MAX_PATH], dirname[9][MAX_PATH], filename[MAX_PATH];
+    DWORD attrs;
+    HANDLE h;
+    BOOL ret;
+    int i, j, pass;
+
+    GetTempPathA( MAX_PATH, temppath );
+    for (i = 0; i < ARRAY_SIZE(dirname); i++)
+    {
+        sprintf( dirname[i], "%sLargeDirCase%u", temppath, i );
+        ret = CreateDirectoryA( dirname[i], NULL );
+        ok( ret, "CreateDirectory failed %lu\n", GetLastError() );
+
+        for (j = 0; j < 300; j++)
+        {
+            sprintf( filename, "%s\\Some_File_%03u.Txt", dirname[i], j );
+            h = CreateFileA( filename, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, 0 );
+            ok( h != INVALID_HANDLE_VALUE, "failed to create %s\n", filename );
+            CloseHandle( h );
+        }
+    }
+
+    /* lookups in recently modified directories */
+    for (i = 0; i < 300; i++)
+    {
+        sprintf( filename, "%s\\sOME_fILE_%03u.tXT", dirname[0], i );
+        attrs = GetFileAttributesA( filename );
+        ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+    }
+
+    /* directories that haven't been modified for a while may be indexed;
+     * there are more of them than Wine keeps indexes for */
+    for (i = 0; i < ARRAY_SIZE(dirname); i++) set_directory_age( dirname[i], 1 );
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < ARRAY_SIZE(dirname); i++)
+        {
+            sprintf( filename, "%s\\SOME_FILE_300.TXT", dirname[i] );
+            attrs = GetFileAttributesA( filename );
+            ok( attrs == INVALID_FILE_ATTRIBUTES, "%s found\n", filename );
+            sprintf( filename, "%s\\some_file_%03u.txt", dirname[i], 299 - i );
+            attrs = GetFileAttributesA( filename );
+            ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+        }
+    }
+    for (i = 0; i < 300; i++)
+    {
+        sprintf( filename, "%s\\sOME_fILE_%03u.tXT", dirname[0], i );
+        attrs = GetFileAttributesA( filename );
+        ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+    }
+
+    /* changes to the directory are seen by further lookups */
+    sprintf( filename, "%s\\Some_File_300.Txt", dirname[0] );
+    h = CreateFileA( filename, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, 0 );
+    ok( h != INVALID_HANDLE_VALUE, "failed to create %s\n", filename );
+    CloseHandle( h );
+    sprintf( filename, "%s\\SOME_FILE_300.TXT", dirname[0] );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+
+    set_directory_age( dirname[0], 2 );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+    sprintf( filename, "%s\\SOME_FILE_301.TXT", dirname[0] );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs == INVALID_FILE_ATTRIBUTES, "%s found\n", filename );
+
+    sprintf( filename, "%s\\some_file_000.txt", dirname[0] );
+    ret = DeleteFileA( filename );
+    ok( ret, "DeleteFile failed %lu\n", GetLastError() );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs == INVALID_FILE_ATTRIBUTES, "%s found\n", filename );
+
+    set_directory_age( dirname[0], 3 );
+    sprintf( filename, "%s\\SOME_FILE_000.TXT", dirname[0] );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs == INVALID_FILE_ATTRIBUTES, "%s found\n", filename );
+    sprintf( filename, "%s\\SOME_FILE_001.TXT", dirname[0] );
+    attrs = GetFileAttributesA( filename );
+    ok( attrs != INVALID_FILE_ATTRIBUTES, "%s not found\n", filename );
+
+    for (i = 0; i < ARRAY_SIZE(dirname); i++)
+    {
+        for (j = !i; j <= (i ? 299 : 300); j++)
+        {
+            sprintf( filename, "%s\\SOME_FILE_%03u.TXT", dirname[i], j );
+            ret = DeleteFileA( filename );
+            ok( ret, "DeleteFile %s failed %lu\n", filename, GetLastError() );
+        }
+        ret = RemoveDirectoryA( dirname[i] );
+        ok( ret, "RemoveDirectory failed %lu\n", GetLastError() );
+    }
+}
+
 static void test_file_mode(void)
 {
     UNICODE_STRING file_name, pipe_dev_name, mountmgr_dev_name, mailslot_dev_name;
@@ -5310,10 +5429,18 @@ static void test_read_write(void)
 static void test_ioctl(void)
 {
     HANDLE event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    struct
+    {
+        FILE_FS_ATTRIBUTE_INFORMATION info;
+        WCHAR name[MAX_PATH];
+    } attr_info;
     FILE_PIPE_PEEK_BUFFER peek_buf;
+    DUPLICATE_EXTENTS_DATA extents;
     IO_STATUS_BLOCK iosb;
-    HANDLE file;
+    char buffer[4096] = {0};
+    HANDLE file, source;
     NTSTATUS status;
+    DWORD size;
 
     file = create_temp_file(FILE_FLAG_OVERLAPPED);
     ok(file != INVALID_HANDLE_VALUE, "could not create temp file\n");
@@ -5334,6 +5461,28 @@ static void test_ioctl(void)
     ok(status == STATUS_INVALID_DEVICE_REQUEST, "NtFsControlFile failed: %lx\n", status);
     ok(iosb.Status == 0x55555555, "iosb.Status = %lx\n", iosb.Status);
 
+    status = pNtQueryVolumeInformationFile(file, &iosb, &attr_info, sizeof(attr_info), FileFsAttributeInformation);
+    ok(!status || status == STATUS_BUFFER_OVERFLOW, "NtQueryVolumeInformationFile failed: %lx\n", status);
+    if (attr_info.info.FileSystemAttributes & FILE_SUPPORTS_BLOCK_REFCOUNTING)
+        skip("file system supports block cloning\n");
+    else
+    {
+        source = create_temp_file(0);
+        WriteFile(source, buffer, sizeof(buffer), &size, NULL);
+        extents.FileHandle = source;
+        extents.SourceFileOffset.QuadPart = 0;
+        extents.TargetFileOffset.QuadPart = 0;
+        extents.ByteCount.QuadPart = sizeof(buffer);
+        memset(&iosb, 0x55, sizeof(iosb));
+        status = pNtFsControlFile(file, NULL, NULL, NULL, &iosb, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                                  &extents, sizeof(extents), NULL, 0);
+        ok(status == STATUS_INVALID_DEVICE_REQUEST, "NtFsControlFile returned %lx\n", status);
+        ok(iosb.Status == 0x55555555, "iosb.Status = %lx\n", iosb.Status);
+        size = GetFileSize(file, NULL);
+        ok(!size, "got size %lu\n", size);
+        CloseHandle(source);
+    }
+
     CloseHandle(event);
     CloseHandle(file);
 }
@@ -5712,6 +5861,7 @@ START_TEST(file)
     test_file_access_information();
     test_file_attribute_tag_information();
     test_dotfile_file_attributes();
+    test_large_directory_case();
     test_file_mode();
     test_file_readonly_access();
     test_query_volume_information_file();
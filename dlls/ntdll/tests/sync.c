@@ -46,6 +46,7 @@ static NTSTATUS (WINAPI *pNtResetEvent)( HANDLE, LONG * );
 static NTSTATUS (WINAPI *pNtSetEvent)( HANDLE, LONG * );
 static NTSTATUS (WINAPI *pNtWaitForAlertByThreadId)( void *, const LARGE_INTEGER * );
 static NTSTATUS (WINAPI *pNtWaitForKeyedEvent)( HANDLE, const void *, BOOLEAN, const LARGE_INTEGER * );
+static NTSTATUS (WINAPI *pNtWaitForMultipleObjects)( ULONG, const HANDLE *, WAIT_TYPE, BOOLEAN, const LARGE_INTEGER * );
 static BOOLEAN  (WINAPI *pRtlAcquireResourceExclusive)( RTL_RWLOCK *, BOOLEAN );
 static BOOLEAN  (WINAPI *pRtlAcquireResourceShared)( RTL_RWLOCK *, BOOLEAN );
 static void     (WINAPI *pRtlDeleteResource)( RTL_RWLOCK * );
@@ -901,6 +902,49 @@ static void test_close_io_completion(void)
     CloseHandle( thread );
 }
 
+static void test_wait_multiple_reuse(void)
+{
+    LARGE_INTEGER zero = {{0}};
+    HANDLE events[2];
+    NTSTATUS status;
+    unsigned int i;
+
+    status = pNtCreateEvent( &events[0], EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+    ok( !status, "Got unexpected status %#x.\n", status );
+    status = pNtCreateEvent( &events[1], EVENT_ALL_ACCESS, NULL, NotificationEvent, TRUE );
+    ok( !status, "Got unexpected status %#x.\n", status );
+
+    for (i = 0; i < 8; ++i)
+    {
+        status = pNtWaitForMultipleObjects( 2, events, WaitAny, FALSE, &zero );
+        ok( status == 1, "Got unexpected status %#x.\n", status );
+        status = pNtWaitForMultipleObjects( 2, events, WaitAll, FALSE, &zero );
+        ok( status == STATUS_TIMEOUT, "Got unexpected status %#x.\n", status );
+    }
+
+    pNtSetEvent( events[0], NULL );
+    status = pNtWaitForMultipleObjects( 2, events, WaitAll, FALSE, &zero );
+    ok( !status, "Got unexpected status %#x.\n", status );
+    status = pNtWaitForMultipleObjects( 2, events, WaitAll, FALSE, &zero );
+    ok( status == STATUS_TIMEOUT, "Got unexpected status %#x.\n", status );
+
+    /* the same handles must be looked up again once one of them is closed */
+    pNtClose( events[1] );
+    status = pNtWaitForMultipleObjects( 2, events, WaitAny, FALSE, &zero );
+    ok( status == STATUS_INVALID_HANDLE, "Got unexpected status %#x.\n", status );
+
+    status = pNtCreateEvent( &events[1], EVENT_ALL_ACCESS, NULL, NotificationEvent, FALSE );
+    ok( !status, "Got unexpected status %#x.\n", status );
+    status = pNtWaitForMultipleObjects( 2, events, WaitAny, FALSE, &zero );
+    ok( status == STATUS_TIMEOUT, "Got unexpected status %#x.\n", status );
+    pNtSetEvent( events[1], NULL );
+    status = pNtWaitForMultipleObjects( 2, events, WaitAny, FALSE, &zero );
+    ok( status == 1, "Got unexpected status %#x.\n", status );
+
+    pNtClose( events[0] );
+    pNtClose( events[1] );
+}
+
 START_TEST(sync)
 {
     HMODULE module = GetModuleHandleA("ntdll.dll");
@@ -931,6 +975,7 @@ START_TEST(sync)
     pNtSetEvent                     = (void *)GetProcAddress(module, "NtSetEvent");
     pNtWaitForAlertByThreadId       = (void *)GetProcAddress(module, "NtWaitForAlertByThreadId");
     pNtWaitForKeyedEvent            = (void *)GetProcAddress(module, "NtWaitForKeyedEvent");
+    pNtWaitForMultipleObjects       = (void *)GetProcAddress(module, "NtWaitForMultipleObjects");
     pRtlAcquireResourceExclusive    = (void *)GetProcAddress(module, "RtlAcquireResourceExclusive");
     pRtlAcquireResourceShared       = (void *)GetProcAddress(module, "RtlAcquireResourceShared");
     pRtlDeleteResource              = (void *)GetProcAddress(module, "RtlDeleteResource");
@@ -949,4 +994,5 @@ START_TEST(sync)
     test_resource();
     test_tid_alert( argv );
     test_close_io_completion();
+    test_wait_multiple_reuse();
 }
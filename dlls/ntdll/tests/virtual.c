@@ -2106,6 +2106,241 @@ static void test_query_region_information(void)
     NtClose(mapping);
 }
 
+static void test_large_pages(void)
+{
+    MEMORY_WORKING_SET_EX_INFORMATION info;
+    TOKEN_PRIVILEGES privs, old_privs;
+    SIZE_T large_page_size, size;
+    NTSTATUS status;
+    HANDLE token;
+    ULONG len;
+    void *addr;
+
+    large_page_size = GetLargePageMinimum();
+    if (!large_page_size)
+    {
+        skip("Large pages are not supported.\n");
+        return;
+    }
+
+    addr = NULL;
+    size = large_page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(status == STATUS_PRIVILEGE_NOT_HELD, "Unexpected status %08lx.\n", status);
+
+    status = NtOpenProcessToken(NtCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    privs.PrivilegeCount = 1;
+    privs.Privileges[0].Luid.LowPart = SE_LOCK_MEMORY_PRIVILEGE;
+    privs.Privileges[0].Luid.HighPart = 0;
+    privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    status = NtAdjustPrivilegesToken(token, FALSE, &privs, sizeof(old_privs), &old_privs, &len);
+    if (status == STATUS_NOT_ALL_ASSIGNED)
+    {
+        skip("SeLockMemoryPrivilege is not available.\n");
+        NtClose(token);
+        return;
+    }
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+
+    /* large pages must be reserved and committed at once */
+    addr = NULL;
+    size = large_page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(status == STATUS_INVALID_PARAMETER, "Unexpected status %08lx.\n", status);
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(status == STATUS_INVALID_PARAMETER, "Unexpected status %08lx.\n", status);
+
+    /* the size must be a multiple of the large page size */
+    size = large_page_size + page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(status == STATUS_INVALID_PARAMETER, "Unexpected status %08lx.\n", status);
+
+    /* and so must the base address */
+    size = 2 * large_page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size, MEM_RESERVE, PAGE_NOACCESS);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    size = 0;
+    status = NtFreeVirtualMemory(NtCurrentProcess(), &addr, &size, MEM_RELEASE);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    addr = (char *)(((ULONG_PTR)addr + large_page_size - 1) & ~(large_page_size - 1)) + 0x10000;
+    size = large_page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(status == STATUS_INVALID_PARAMETER, "Unexpected status %08lx.\n", status);
+
+    addr = NULL;
+    size = large_page_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size,
+                                     MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (status == STATUS_INSUFFICIENT_RESOURCES || status == STATUS_NO_MEMORY)
+        skip("No large pages available.\n");
+    else
+    {
+        ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+        ok(!((ULONG_PTR)addr & (large_page_size - 1)), "Unaligned address %p.\n", addr);
+        ok(size == large_page_size, "Unexpected size %#Ix.\n", size);
+
+        *(volatile char *)addr = 1;
+        info.VirtualAddress = addr;
+        status = NtQueryVirtualMemory(NtCurrentProcess(), NULL, MemoryWorkingSetExInformation,
+                                      &info, sizeof(info), NULL);
+        ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+        ok(info.VirtualAttributes.Valid, "Page is not valid.\n");
+        ok(info.VirtualAttributes.LargePage, "Page is not a large page.\n");
+
+        size = 0;
+        status = NtFreeVirtualMemory(NtCurrentProcess(), &addr, &size, MEM_RELEASE);
+        ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    }
+
+    status = NtAdjustPrivilegesToken(token, FALSE, &old_privs, 0, NULL, NULL);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    NtClose(token);
+}
+
+static void test_relocated_image_sharing(void)
+{
+    static const char testfile[] = "testreloc.dll";
+    struct image_headers
+    {
+        IMAGE_DOS_HEADER dos;
+        IMAGE_NT_HEADERS nt;
+        IMAGE_SECTION_HEADER section;
+    } *headers;
+    struct image_data
+    {
+        IMAGE_BASE_RELOCATION rel;
+        WORD fixups[2];
+        ULONG_PTR ptr;
+    } *data;
+    MEMORY_WORKING_SET_EX_INFORMATION info;
+    char image[0x400];
+    HANDLE file, mapping, process;
+    void *reserved = NULL, *ptr = NULL, *ptr2;
+    ULONG_PTR value;
+    SIZE_T size;
+    NTSTATUS status;
+    DWORD written;
+    BOOL ret;
+
+    /* reserve the preferred base so that the image has to be relocated */
+    size = 0x10000;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &reserved, 0, &size, MEM_RESERVE, PAGE_NOACCESS);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+
+    memset(image, 0, sizeof(image));
+    headers = (void *)image;
+    headers->dos.e_magic = IMAGE_DOS_SIGNATURE;
+    headers->dos.e_lfanew = offsetof(struct image_headers, nt);
+    headers->nt.Signature = IMAGE_NT_SIGNATURE;
+    headers->nt.FileHeader.Machine = RtlImageNtHeader(GetModuleHandleA(NULL))->FileHeader.Machine;
+    headers->nt.FileHeader.NumberOfSections = 1;
+    headers->nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    headers->nt.FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_DLL;
+    headers->nt.OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR_MAGIC;
+    headers->nt.OptionalHeader.ImageBase = (ULONG_PTR)reserved;
+    headers->nt.OptionalHeader.SectionAlignment = page_size;
+    headers->nt.OptionalHeader.FileAlignment = 0x200;
+    headers->nt.OptionalHeader.MajorOperatingSystemVersion = 4;
+    headers->nt.OptionalHeader.MajorSubsystemVersion = 4;
+    headers->nt.OptionalHeader.SizeOfImage = 3 * page_size;
+    headers->nt.OptionalHeader.SizeOfHeaders = 0x200;
+    headers->nt.OptionalHeader.Subsystem = IMAGE_SUBSYSTEM_WINDOWS_CUI;
+    headers->nt.OptionalHeader.DllCharacteristics = IMAGE_DLLCHARACTERISTICS_DYNAMIC_BASE |
+                                                     IMAGE_DLLCHARACTERISTICS_NX_COMPAT;
+    headers->nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    headers->nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].VirtualAddress = page_size;
+    headers->nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].Size =
+        offsetof(struct image_data, ptr);
+    memcpy(headers->section.Name, ".data", sizeof(".data"));
+    headers->section.Misc.VirtualSize = 2 * page_size;
+    headers->section.VirtualAddress = page_size;
+    headers->section.SizeOfRawData = 0x200;
+    headers->section.PointerToRawData = 0x200;
+    headers->section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+
+    data = (void *)(image + 0x200);
+    data->rel.VirtualAddress = page_size;
+    data->rel.SizeOfBlock = offsetof(struct image_data, ptr);
+    data->fixups[0] = (sizeof(ULONG_PTR) == 8 ? IMAGE_REL_BASED_DIR64 : IMAGE_REL_BASED_HIGHLOW) << 12 |
+                      offsetof(struct image_data, ptr);
+    data->fixups[1] = IMAGE_REL_BASED_ABSOLUTE << 12;
+    data->ptr = (ULONG_PTR)reserved + page_size;
+
+    file = CreateFileA(testfile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to create test file\n");
+    ret = WriteFile(file, image, sizeof(image), &written, NULL);
+    ok(ret, "WriteFile failed, error %lu\n", GetLastError());
+    CloseHandle(file);
+
+    file = CreateFileA(testfile, GENERIC_READ | GENERIC_EXECUTE, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open test file\n");
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY | SEC_IMAGE, 0, 0, NULL);
+    ok(mapping != 0, "CreateFileMapping failed, error %lu\n", GetLastError());
+    CloseHandle(file);
+
+    size = 0;
+    status = NtMapViewOfSection(mapping, NtCurrentProcess(), &ptr, 0, 0, NULL, &size, ViewShare, 0, PAGE_READONLY);
+    ok(status == STATUS_IMAGE_NOT_AT_BASE || status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    ok(ptr != reserved, "Image mapped at reserved address %p.\n", ptr);
+
+    /* the relocations are applied when the image is mapped */
+    headers = ptr;
+    data = (void *)((char *)ptr + page_size);
+    ok(headers->nt.OptionalHeader.ImageBase == (ULONG_PTR)ptr, "Got image base %#Ix.\n",
+       (ULONG_PTR)headers->nt.OptionalHeader.ImageBase);
+    ok(data->ptr == (ULONG_PTR)ptr + page_size, "Got value %#Ix.\n", data->ptr);
+
+    info.VirtualAddress = data;
+    status = NtQueryVirtualMemory(NtCurrentProcess(), NULL, MemoryWorkingSetExInformation,
+                                  &info, sizeof(info), NULL);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    ok(info.VirtualAttributes.Valid, "Page is not valid.\n");
+    ok(info.VirtualAttributes.Shared, "Relocated page is not shared.\n");
+
+    /* another process mapping it at the same address gets the same relocated pages */
+    process = create_target_process("sleep");
+    ok(process != NULL, "Can't start process\n");
+
+    ptr2 = ptr;
+    size = 0;
+    status = NtMapViewOfSection(mapping, process, &ptr2, 0, 0, NULL, &size, ViewShare, 0, PAGE_READONLY);
+    ok(status == STATUS_IMAGE_NOT_AT_BASE || status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    ok(ptr2 == ptr, "Image mapped at %p instead of %p.\n", ptr2, ptr);
+
+    ret = ReadProcessMemory(process, &data->ptr, &value, sizeof(value), &size);
+    ok(ret, "ReadProcessMemory failed, error %lu\n", GetLastError());
+    ok(value == (ULONG_PTR)ptr + page_size, "Got value %#Ix.\n", value);
+
+    status = NtUnmapViewOfSection(process, ptr2);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    TerminateProcess(process, 0);
+    WaitForSingleObject(process, INFINITE);
+    CloseHandle(process);
+
+    status = NtUnmapViewOfSection(NtCurrentProcess(), ptr);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+    NtClose(mapping);
+
+    /* the relocated pages don't keep the file from being replaced once it's unmapped */
+    file = CreateFileA(testfile, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, 0);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open test file for writing, error %lu\n", GetLastError());
+    ret = WriteFile(file, image, sizeof(image), &written, NULL);
+    ok(ret, "WriteFile failed, error %lu\n", GetLastError());
+    CloseHandle(file);
+    ret = DeleteFileA(testfile);
+    ok(ret, "DeleteFile failed, error %lu\n", GetLastError());
+
+    size = 0;
+    status = NtFreeVirtualMemory(NtCurrentProcess(), &reserved, &size, MEM_RELEASE);
+    ok(status == STATUS_SUCCESS, "Unexpected status %08lx.\n", status);
+}
+
 START_TEST(virtual)
 {
     HMODULE mod;
@@ -2153,4 +2388,6 @@ START_TEST(virtual)
     test_user_shared_data();
     test_syscalls();
     test_query_region_information();
+    test_large_pages();
+    test_relocated_image_sharing();
 }
@@ -123,6 +123,7 @@
 #include "ddk/mountmgr.h"
 #include "wine/server.h"
 #include "wine/list.h"
+#include "wine/fsctl.h"
 #include "wine/debug.h"
 #include "unix_private.h"
 
@@ -135,6 +136,7 @@ WINE_DECLARE_DEBUG_CHANNEL(winediag);
 #undef VFAT_IOCTL_READDIR_BOTH
 #undef EXT2_IOC_GETFLAGS
 #undef EXT4_CASEFOLD_FL
+#undef FICLONERANGE
 
 #ifdef linux
 
@@ -156,6 +158,16 @@ typedef struct
 /* Case-insensitivity attribute */
 #define EXT4_CASEFOLD_FL 0x40000000
 
+/* Define the ioctl to share the extents of a file range with another file */
+typedef struct
+{
+    INT64 src_fd;
+    UINT64 src_offset;
+    UINT64 src_length;
+    UINT64 dest_offset;
+} KERNEL_FILE_CLONE_RANGE;
+#define FICLONERANGE _IOW(0x94, 13, KERNEL_FILE_CLONE_RANGE)
+
 #ifndef O_DIRECTORY
 # define O_DIRECTORY 0200000 /* must be directory */
 #endif
@@ -2731,6 +2743,226 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+/* case-insensitive index of the entries of a directory */
+struct dir_index_entry
+{
+    unsigned int name;        /* offset of the Unix name in the names buffer */
+    unsigned int hash;        /* hash of the long name */
+    unsigned int short_hash;  /* hash of the hashed short name, if the name is not a legal 8.3 one */
+    int          next;        /* next entry in the same long name bucket */
+    int          next_short;  /* next entry in the same short name bucket */
+};
+
+struct dir_index
+{
+    struct list             entry;          /* entry in dir_index_list */
+    struct stat             st;             /* stat of the directory at the time it was read */
+    unsigned int            count;          /* number of entries */
+    unsigned int            hash_mask;      /* number of buckets - 1 */
+    int                    *buckets;        /* first entry of each long name bucket */
+    int                    *short_buckets;  /* first entry of each short name bucket */
+    struct dir_index_entry *entries;
+    char                   *names;          /* buffer of the Unix names of all entries */
+};
+
+#define DIR_INDEX_MIN_ENTRIES 256  /* smaller directories are not worth caching */
+#define DIR_INDEX_MAX_CACHED  8
+
+static struct list dir_index_list = LIST_INIT( dir_index_list );
+static unsigned int dir_index_cached;
+static pthread_mutex_t dir_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hash_dir_entry_name( const WCHAR *name, int len )
+{
+    unsigned int hash = 0;
+    while (len--) hash = hash * 31 + towupper( *name++ );
+    return hash;
+}
+
+static void free_dir_index( struct dir_index *index )
+{
+    free( index->buckets );
+    free( index->entries );
+    free( index->names );
+    free( index );
+}
+
+/* check that a cached directory index is still up to date */
+static BOOL is_dir_index_current( const struct dir_index *index, const struct stat *st )
+{
+    if (index->st.st_mtime != st->st_mtime || index->st.st_ctime != st->st_ctime) return FALSE;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    if (index->st.st_mtim.tv_nsec != st->st_mtim.tv_nsec) return FALSE;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    if (index->st.st_mtimespec.tv_nsec != st->st_mtimespec.tv_nsec) return FALSE;
+#endif
+    return TRUE;
+}
+
+/***********************************************************************
+ *           create_dir_index
+ *
+ * Read a whole directory and index its entries by case-insensitive long and short names.
+ */
+static NTSTATUS create_dir_index( DIR *dir, const struct stat *st, struct dir_index **ret )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    unsigned int i, len, names_size = 0, names_len = 0, size = 0, hash_size;
+    struct dir_index *index;
+    struct dir_index_entry *entry;
+    struct dirent *de;
+    int wlen;
+    void *ptr;
+
+    if (!(index = calloc( 1, sizeof(*index) ))) return STATUS_NO_MEMORY;
+    index->st = *st;
+
+    rewinddir( dir );
+    while ((de = readdir( dir )))
+    {
+        if (index->count == size)
+        {
+            size = max( 64, size * 2 );
+            if (!(ptr = realloc( index->entries, size * sizeof(*index->entries) ))) goto nomem;
+            index->entries = ptr;
+        }
+        len = strlen( de->d_name ) + 1;
+        if (names_len + len > names_size)
+        {
+            names_size = max( 4096, max( names_size * 2, names_len + len ));
+            if (!(ptr = realloc( index->names, names_size ))) goto nomem;
+            index->names = ptr;
+        }
+        entry = &index->entries[index->count++];
+        entry->name = names_len;
+        memcpy( index->names + names_len, de->d_name, len );
+        names_len += len;
+
+        wlen = ntdll_umbstowcs( de->d_name, len - 1, buffer, MAX_DIR_ENTRY_LEN );
+        entry->hash = hash_dir_entry_name( buffer, wlen );
+        entry->next_short = -2;  /* not in the short name buckets */
+        if (!is_legal_8dot3_name( buffer, wlen ))
+        {
+            wlen = hash_short_file_name( buffer, wlen, short_nameW );
+            entry->short_hash = hash_dir_entry_name( short_nameW, wlen );
+            entry->next_short = -1;
+        }
+    }
+
+    for (hash_size = 64; hash_size < index->count; hash_size *= 2) ;
+    if (!(index->buckets = malloc( 2 * hash_size * sizeof(*index->buckets) ))) goto nomem;
+    index->short_buckets = index->buckets + hash_size;
+    index->hash_mask = hash_size - 1;
+    for (i = 0; i < 2 * hash_size; i++) index->buckets[i] = -1;
+
+    /* insert in reverse order so that the chains are in directory order */
+    for (i = index->count; i--; )
+    {
+        entry = &index->entries[i];
+        entry->next = index->buckets[entry->hash & index->hash_mask];
+        index->buckets[entry->hash & index->hash_mask] = i;
+        if (entry->next_short == -2) continue;
+        entry->next_short = index->short_buckets[entry->short_hash & index->hash_mask];
+        index->short_buckets[entry->short_hash & index->hash_mask] = i;
+    }
+    *ret = index;
+    return STATUS_SUCCESS;
+
+nomem:
+    free_dir_index( index );
+    return STATUS_NO_MEMORY;
+}
+
+/* find a name in a directory index, return the index of the entry or -1 */
+static int find_dir_index_entry( const struct dir_index *index, const WCHAR *name, int length,
+                                 BOOLEAN is_name_8_dot_3 )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    unsigned int hash = hash_dir_entry_name( name, length );
+    const char *unix_name;
+    int i, ret;
+
+    for (i = index->buckets[hash & index->hash_mask]; i != -1; i = index->entries[i].next)
+    {
+        if (index->entries[i].hash != hash) continue;
+        unix_name = index->names + index->entries[i].name;
+        ret = ntdll_umbstowcs( unix_name, strlen(unix_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (ret == length && !wcsnicmp( buffer, name, ret )) return i;
+    }
+
+    if (!is_name_8_dot_3) return -1;
+
+    for (i = index->short_buckets[hash & index->hash_mask]; i != -1; i = index->entries[i].next_short)
+    {
+        if (index->entries[i].short_hash != hash) continue;
+        unix_name = index->names + index->entries[i].name;
+        ret = ntdll_umbstowcs( unix_name, strlen(unix_name), buffer, MAX_DIR_ENTRY_LEN );
+        ret = hash_short_file_name( buffer, ret, short_nameW );
+        if (ret == length && !wcsnicmp( short_nameW, name, length )) return i;
+    }
+    return -1;
+}
+
+/***********************************************************************
+ *           find_file_in_dir_index
+ *
+ * Case-insensitive search of a file in a directory index.
+ * The file found is appended to unix_name at pos.
+ */
+static BOOL find_file_in_dir_index( const struct dir_index *index, char *unix_name, int pos,
+                                    const WCHAR *name, int length, BOOLEAN is_name_8_dot_3 )
+{
+    int i = find_dir_index_entry( index, name, length, is_name_8_dot_3 );
+
+    if (i == -1) return FALSE;
+    strcpy( unix_name + pos, index->names + index->entries[i].name );
+    return TRUE;
+}
+
+/* find the cached index of a directory, dropping it if the directory has changed */
+static struct dir_index *get_cached_dir_index( const struct stat *st )
+{
+    struct dir_index *index;
+
+    LIST_FOR_EACH_ENTRY( index, &dir_index_list, struct dir_index, entry )
+    {
+        if (index->st.st_dev != st->st_dev || index->st.st_ino != st->st_ino) continue;
+        list_remove( &index->entry );
+        if (is_dir_index_current( index, st ))
+        {
+            list_add_head( &dir_index_list, &index->entry );
+            return index;
+        }
+        free_dir_index( index );
+        dir_index_cached--;
+        return NULL;
+    }
+    return NULL;
+}
+
+/* add a directory index to the cache, evicting the least recently used one if needed */
+static void cache_dir_index( struct dir_index *index )
+{
+    struct dir_index *old;
+
+    /* another thread may have indexed the same directory in the meantime */
+    if ((old = get_cached_dir_index( &index->st )))
+    {
+        list_remove( &old->entry );
+        free_dir_index( old );
+        dir_index_cached--;
+    }
+    list_add_head( &dir_index_list, &index->entry );
+    if (++dir_index_cached > DIR_INDEX_MAX_CACHED)
+    {
+        old = LIST_ENTRY( list_tail( &dir_index_list ), struct dir_index, entry );
+        list_remove( &old->entry );
+        free_dir_index( old );
+        dir_index_cached--;
+    }
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2742,10 +2974,14 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
                                   BOOLEAN check_case )
 {
     WCHAR buffer[MAX_DIR_ENTRY_LEN];
-    BOOLEAN is_name_8_dot_3;
+    BOOLEAN is_name_8_dot_3, cacheable = FALSE;
+    struct dir_index *index;
     DIR *dir;
     struct dirent *de;
     struct stat st;
+    unsigned int count = 0;
+    NTSTATUS status;
+    BOOL found;
     int ret;
 
     /* try a shortcut for this directory */
@@ -2824,6 +3060,22 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
 
     unix_name[pos - 1] = '/';
+    if (!fstat( dirfd( dir ), &st ))
+    {
+        mutex_lock( &dir_index_mutex );
+        if ((index = get_cached_dir_index( &st )))
+        {
+            found = find_file_in_dir_index( index, unix_name, pos, name, length, is_name_8_dot_3 );
+            mutex_unlock( &dir_index_mutex );
+            closedir( dir );
+            if (found) return STATUS_SUCCESS;
+            goto not_found;
+        }
+        mutex_unlock( &dir_index_mutex );
+        /* a directory that could still be modified within the same timestamp can't be cached */
+        cacheable = st.st_mtime < time(NULL) - 1;
+    }
+
     while ((de = readdir( dir )))
     {
         ret = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
@@ -2834,9 +3086,7 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
             return STATUS_SUCCESS;
         }
 
-        if (!is_name_8_dot_3) continue;
-
-        if (!is_legal_8dot3_name( buffer, ret ))
+        if (is_name_8_dot_3 && !is_legal_8dot3_name( buffer, ret ))
         {
             WCHAR short_nameW[12];
             ret = hash_short_file_name( buffer, ret, short_nameW );
@@ -2847,6 +3097,24 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
                 return STATUS_SUCCESS;
             }
         }
+
+        if (cacheable && ++count == DIR_INDEX_MIN_ENTRIES)
+        {
+            /* large directory, index it for the next lookups */
+            status = create_dir_index( dir, &st, &index );
+            closedir( dir );
+            if (status)
+            {
+                unix_name[pos - 1] = 0;
+                return status;
+            }
+            found = find_file_in_dir_index( index, unix_name, pos, name, length, is_name_8_dot_3 );
+            mutex_lock( &dir_index_mutex );
+            cache_dir_index( index );
+            mutex_unlock( &dir_index_mutex );
+            if (found) return STATUS_SUCCESS;
+            goto not_found;
+        }
     }
     closedir( dir );
 
@@ -6432,6 +6700,77 @@ static void ignore_server_ioctl_struct_holes( ULONG code, const void *in_buffer,
 }
 
 
+/* copy a range of a file into another one, sharing the extents if the filesystem supports it;
+ * fewer bytes than requested are copied if the source ends first */
+static NTSTATUS copy_file_data( HANDLE src, HANDLE dst, LONGLONG src_offset, LONGLONG dst_offset,
+                                LONGLONG count, ULONG_PTR *copied )
+{
+    int src_fd, dst_fd, src_needs_close, dst_needs_close;
+    enum server_fd_type src_type, dst_type;
+    NTSTATUS status;
+
+    *copied = 0;
+    if (src_offset < 0 || dst_offset < 0 || count < 0 || count > MAXLONG) return STATUS_INVALID_PARAMETER;
+    if (!count) return STATUS_SUCCESS;
+
+    if ((status = server_get_unix_fd( src, FILE_READ_DATA, &src_fd, &src_needs_close, &src_type, NULL )))
+        return status;
+    if ((status = server_get_unix_fd( dst, FILE_WRITE_DATA, &dst_fd, &dst_needs_close, &dst_type, NULL )))
+    {
+        if (src_needs_close) close( src_fd );
+        return status;
+    }
+
+    if (src_type != FD_TYPE_FILE || dst_type != FD_TYPE_FILE) status = STATUS_INVALID_PARAMETER;
+    else
+    {
+        status = STATUS_NOT_SUPPORTED;
+#ifdef FICLONERANGE
+        {
+            KERNEL_FILE_CLONE_RANGE range;
+
+            range.src_fd      = src_fd;
+            range.src_offset  = src_offset;
+            range.src_length  = count;
+            range.dest_offset = dst_offset;
+            if (!ioctl( dst_fd, FICLONERANGE, &range ))
+            {
+                *copied = count;
+                status = STATUS_SUCCESS;
+            }
+            else TRACE( "FICLONERANGE failed: %s\n", strerror( errno ) );
+        }
+#endif
+#ifdef HAVE_COPY_FILE_RANGE
+        /* let the kernel copy it, possibly through server-side copy */
+        while (status && count)
+        {
+            loff_t src_pos = src_offset, dst_pos = dst_offset;
+            ssize_t ret = copy_file_range( src_fd, &src_pos, dst_fd, &dst_pos, min( count, 0x40000000 ), 0 );
+
+            if (ret < 0)
+            {
+                if (errno == EINTR) continue;
+                TRACE( "copy_file_range failed: %s\n", strerror( errno ) );
+                if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)
+                    status = errno_to_status( errno );
+                break;
+            }
+            src_offset += ret;
+            dst_offset += ret;
+            count -= ret;
+            *copied += ret;
+            if (!ret || !count) status = STATUS_SUCCESS;  /* done, or end of file */
+        }
+#endif
+    }
+
+    if (src_needs_close) close( src_fd );
+    if (dst_needs_close) close( dst_fd );
+    return status;
+}
+
+
 /******************************************************************************
  *              NtFsControlFile   (NTDLL.@)
  */
@@ -6525,6 +6864,26 @@ NTSTATUS WINAPI NtFsControlFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE ap
         break;
     }
 
+    case FSCTL_DUPLICATE_EXTENTS_TO_FILE:
+        /* block cloning is only supported on ReFS */
+        io->Information = 0;
+        status = STATUS_INVALID_DEVICE_REQUEST;
+        break;
+
+    case FSCTL_WINE_COPY_FILE_RANGE:
+    {
+        const DUPLICATE_EXTENTS_DATA *data = in_buffer;
+        ULONG_PTR copied = 0;
+
+        if (in_size < sizeof(*data)) status = STATUS_INVALID_PARAMETER;
+        /* the handle is in the low 32 bits for WoW64 processes too */
+        else status = copy_file_data( LongToHandle( (LONG)(ULONG_PTR)data->FileHandle ), handle,
+                                      data->SourceFileOffset.QuadPart, data->TargetFileOffset.QuadPart,
+                                      data->ByteCount.QuadPart, &copied );
+        io->Information = copied;
+        break;
+    }
+
     case FSCTL_SET_SPARSE:
         TRACE("FSCTL_SET_SPARSE: Ignoring request\n");
         io->Information = 0;
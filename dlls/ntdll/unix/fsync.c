@@ -458,6 +458,16 @@ static NTSTATUS get_object_for_wait( HANDLE handle, struct fsync *obj, int *prev
     return STATUS_SUCCESS;
 }
 
+/* Returns the cached list entry a handle was resolved to, without grabbing the object. */
+static BOOL get_cached_entry( HANDLE handle, struct fsync_cache *cache )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+
+    if ((INT_PTR)handle < 0 || entry >= FSYNC_LIST_ENTRIES || !fsync_list[entry]) return FALSE;
+    *(uint64_t *)cache = __atomic_load_n( (uint64_t *)&fsync_list[entry][idx], __ATOMIC_SEQ_CST );
+    return cache->type && cache->shm_idx;
+}
+
 NTSTATUS fsync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
@@ -1426,18 +1436,26 @@ static void server_set_msgwait( int in_msgwait )
 NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    struct fsync_cache cache;
+    enum fsync_type type = 0;
     BOOL msgwait = FALSE;
     struct fsync obj;
     NTSTATUS ret;
 
-    if (count && !get_object( handles[count - 1], &obj ))
+    if (count)
     {
-        if (obj.type == FSYNC_QUEUE)
+        if (get_cached_entry( handles[count - 1], &cache ))
+            type = cache.type;
+        else if (!get_object( handles[count - 1], &obj ))
+        {
+            type = obj.type;
+            put_object( &obj );
+        }
+        if (type == FSYNC_QUEUE)
         {
             msgwait = TRUE;
             server_set_msgwait( 1 );
         }
-        put_object( &obj );
     }
 
     ret = __fsync_wait_objects( count, handles, wait_any, alertable, timeout );
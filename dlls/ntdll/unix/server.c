@@ -254,9 +254,30 @@ static void read_reply_data( void *buffer, size_t size )
  */
 static inline unsigned int wait_reply( struct __server_request_info *req )
 {
-    read_reply_data( &req->u.reply, sizeof(req->u.reply) );
-    if (req->u.reply.reply_header.reply_size)
-        read_reply_data( req->reply_data, req->u.reply.reply_header.reply_size );
+    data_size_t max_size = req->u.req.request_header.reply_size, size;
+    struct iovec vec[2];
+    ssize_t ret;
+
+    /* the server sends the reply header and data in a single write, and nothing else can be
+     * in the pipe until we send the next request, so try to get both in a single call */
+    vec[0].iov_base = &req->u.reply;
+    vec[0].iov_len  = sizeof(req->u.reply);
+    vec[1].iov_base = req->reply_data;
+    vec[1].iov_len  = max_size;
+
+    while ((ret = readv( ntdll_get_thread_data()->reply_fd, vec, max_size ? 2 : 1 )) == -1 &&
+           errno == EINTR);
+
+    if (ret < (ssize_t)sizeof(req->u.reply))
+    {
+        if (ret < 0 && errno != EPIPE) server_protocol_perror( "read" );
+        if (ret <= 0) abort_thread(0);  /* the server closed the connection; time to die... */
+        read_reply_data( (char *)&req->u.reply + ret, sizeof(req->u.reply) - ret );
+        ret = sizeof(req->u.reply);
+    }
+    size = ret - sizeof(req->u.reply);
+    if (req->u.reply.reply_header.reply_size > size)
+        read_reply_data( (char *)req->reply_data + size, req->u.reply.reply_header.reply_size - size );
     return req->u.reply.reply_header.error;
 }
 
@@ -380,6 +401,7 @@ static void invoke_system_apc( const apc_call_t *call, apc_result_t *result, BOO
 
         result->type = call->type;
         status = call->async_io.status;
+        user->batch = call->async_io.batch;
         if (user->callback( user, &info, &status ))
         {
             result->async_io.status = status;
@@ -980,7 +1002,9 @@ static inline NTSTATUS get_cached_fd( HANDLE handle, int *fd, enum server_fd_typ
 
     if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return STATUS_INVALID_HANDLE;
 
-    cache.data = InterlockedCompareExchange64( &fd_cache[entry][idx].data, 0, 0 );
+    /* a plain atomic load is enough here, a locked compare-exchange would make
+     * concurrent readers of the same entry fight over its cache line */
+    cache.data = __atomic_load_n( &fd_cache[entry][idx].data, __ATOMIC_ACQUIRE );
     if (!cache.data) return STATUS_INVALID_HANDLE;
 
     /* if fd type is invalid, fd stores an error value */
@@ -25,10 +25,14 @@
 #include "config.h"
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
 #endif
@@ -107,6 +111,85 @@ union unix_sockaddr
 #endif
 };
 
+/* The server may alert a pending datagram request together with the following
+ * requests of the same thread on the same handle (see async_wake_up_batch()).
+ * The first callback then serves all of them with a single recvmmsg() or
+ * sendmmsg(), and saves the results for the callbacks of the others.
+ * Pending requests are kept in per-thread lists hashed by handle, so that
+ * looking up the followers doesn't walk the requests of unrelated sockets. */
+#define MAX_IO_BATCH 16
+#define SOCK_IO_BUCKETS 64
+
+struct sock_io_lists
+{
+    struct list recvs[SOCK_IO_BUCKETS];
+    struct list sends[SOCK_IO_BUCKETS];
+};
+
+enum batch_state
+{
+    BATCH_NONE,     /* the request performs its own I/O */
+    BATCH_DONE,     /* the request was completed by an earlier one */
+    BATCH_EMPTY,    /* no data was left for the request */
+};
+
+struct batch_entry
+{
+    struct list      entry;     /* entry in the thread's pending requests for the handle */
+    enum batch_state state;
+    NTSTATUS         status;
+    ULONG_PTR        size;
+};
+
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+static inline unsigned int sock_io_bucket( HANDLE handle )
+{
+    return ((ULONG_PTR)handle >> 2) % SOCK_IO_BUCKETS;
+}
+
+/* the lists are only allocated once the thread queues a datagram request */
+static struct sock_io_lists *get_sock_io_lists(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    unsigned int i;
+
+    if (!thread_data->sock_io)
+    {
+        struct sock_io_lists *lists;
+
+        if (!(lists = malloc( sizeof(*lists) ))) return NULL;
+        for (i = 0; i < SOCK_IO_BUCKETS; i++)
+        {
+            list_init( &lists->recvs[i] );
+            list_init( &lists->sends[i] );
+        }
+        thread_data->sock_io = lists;
+    }
+    return thread_data->sock_io;
+}
+#endif
+
+/* Sockets on which this process has queued asynchronous requests, hashed by
+ * handle.  The server hands readiness to such requests before it reports it
+ * to a poll, so sock_poll() leaves them to the server.  Bits are never
+ * cleared; a stale or colliding bit only costs a server round trip. */
+static LONG sock_async_bits[64];
+
+static void set_sock_async( HANDLE handle )
+{
+    unsigned int bit = ((ULONG_PTR)handle >> 2) % (ARRAY_SIZE(sock_async_bits) * 32);
+
+    if (!(sock_async_bits[bit / 32] & (1u << (bit % 32))))
+        InterlockedOr( &sock_async_bits[bit / 32], 1u << (bit % 32) );
+}
+
+static BOOL has_sock_async( HANDLE handle )
+{
+    unsigned int bit = ((ULONG_PTR)handle >> 2) % (ARRAY_SIZE(sock_async_bits) * 32);
+
+    return !!(ReadNoFence( &sock_async_bits[bit / 32] ) & (1u << (bit % 32)));
+}
+
 struct async_recv_ioctl
 {
     struct async_fileio io;
@@ -117,6 +200,7 @@ struct async_recv_ioctl
     int unix_flags;
     unsigned int count;
     BOOL icmp_over_dgram;
+    struct batch_entry batch;
     struct iovec iov[1];
 };
 
@@ -129,6 +213,7 @@ struct async_send_ioctl
     unsigned int sent_len;
     unsigned int count;
     unsigned int iov_cursor;
+    struct batch_entry batch;
     struct iovec iov[1];
 };
 
@@ -149,6 +234,7 @@ struct async_transmit_ioctl
     const char *tail;
     unsigned int head_len;
     unsigned int tail_len;
+    BOOL no_sendfile;           /* sendfile() is not supported for this file */
     LARGE_INTEGER offset;
 };
 
@@ -720,44 +806,31 @@ static ssize_t fixup_icmp_over_dgram( struct msghdr *hdr, union unix_sockaddr *u
     return recv_len;
 }
 
-static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *size )
+static void init_recv_msghdr( struct async_recv_ioctl *async, struct msghdr *hdr,
+                              union unix_sockaddr *unix_addr, void *control, size_t control_size )
 {
-#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
-    char control_buffer[512];
-#endif
-    union unix_sockaddr unix_addr;
-    struct msghdr hdr;
-    NTSTATUS status;
-    ssize_t ret;
-
-    memset( &hdr, 0, sizeof(hdr) );
+    memset( hdr, 0, sizeof(*hdr) );
     if (async->addr || async->icmp_over_dgram)
     {
-        hdr.msg_name = &unix_addr.addr;
-        hdr.msg_namelen = sizeof(unix_addr);
+        hdr->msg_name = &unix_addr->addr;
+        hdr->msg_namelen = sizeof(*unix_addr);
     }
-    hdr.msg_iov = async->iov;
-    hdr.msg_iovlen = async->count;
+    hdr->msg_iov = async->iov;
+    hdr->msg_iovlen = async->count;
 #ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
-    hdr.msg_control = control_buffer;
-    hdr.msg_controllen = sizeof(control_buffer);
+    hdr->msg_control = control;
+    hdr->msg_controllen = control_size;
 #endif
-    while ((ret = virtual_locked_recvmsg( fd, &hdr, async->unix_flags )) < 0 && errno == EINTR);
-
-    if (ret < 0)
-    {
-        /* Unix-like systems return EINVAL when attempting to read OOB data from
-         * an empty socket buffer; Windows returns WSAEWOULDBLOCK. */
-        if ((async->unix_flags & MSG_OOB) && errno == EINVAL)
-            errno = EWOULDBLOCK;
+}
 
-        if (errno != EWOULDBLOCK) WARN( "recvmsg: %s\n", strerror( errno ) );
-        return sock_errno_to_status( errno );
-    }
+static NTSTATUS finish_recv( struct async_recv_ioctl *async, struct msghdr *hdr,
+                             union unix_sockaddr *unix_addr, ssize_t ret, ULONG_PTR *size )
+{
+    NTSTATUS status;
 
-    status = (hdr.msg_flags & MSG_TRUNC) ? STATUS_BUFFER_OVERFLOW : STATUS_SUCCESS;
+    status = (hdr->msg_flags & MSG_TRUNC) ? STATUS_BUFFER_OVERFLOW : STATUS_SUCCESS;
     if (async->icmp_over_dgram)
-        ret = fixup_icmp_over_dgram( &hdr, &unix_addr, async->io.handle, ret, &status );
+        ret = fixup_icmp_over_dgram( hdr, unix_addr, async->io.handle, ret, &status );
 
     if (async->control)
     {
@@ -771,7 +844,7 @@ static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *siz
 
             wsabuf.len = sizeof(control_buffer64);
             wsabuf.buf = control_buffer64;
-            if (convert_control_headers( &hdr, &wsabuf ))
+            if (convert_control_headers( hdr, &wsabuf ))
             {
                 if (!wow64_translate_control( &wsabuf, async->control ))
                 {
@@ -789,7 +862,7 @@ static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *siz
         }
         else
         {
-            if (!convert_control_headers( &hdr, async->control ))
+            if (!convert_control_headers( hdr, async->control ))
             {
                 WARN( "Application passed insufficient room for control headers.\n" );
                 *async->ret_flags |= WS_MSG_CTRUNC;
@@ -804,13 +877,102 @@ static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *siz
      * MSDN says that the address is ignored for connection-oriented sockets, so
      * don't try to translate it.
      */
-    if (async->addr && hdr.msg_namelen)
-        *async->addr_len = sockaddr_from_unix( &unix_addr, async->addr, *async->addr_len );
+    if (async->addr && hdr->msg_namelen)
+        *async->addr_len = sockaddr_from_unix( unix_addr, async->addr, *async->addr_len );
 
     *size = ret;
     return status;
 }
 
+static NTSTATUS try_recv( int fd, struct async_recv_ioctl *async, ULONG_PTR *size )
+{
+    char control_buffer[512];
+    union unix_sockaddr unix_addr;
+    struct msghdr hdr;
+    ssize_t ret;
+
+    init_recv_msghdr( async, &hdr, &unix_addr, control_buffer, sizeof(control_buffer) );
+    while ((ret = virtual_locked_recvmsg( fd, &hdr, async->unix_flags )) < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        /* Unix-like systems return EINVAL when attempting to read OOB data from
+         * an empty socket buffer; Windows returns WSAEWOULDBLOCK. */
+        if ((async->unix_flags & MSG_OOB) && errno == EINVAL)
+            errno = EWOULDBLOCK;
+
+        if (errno != EWOULDBLOCK) WARN( "recvmsg: %s\n", strerror( errno ) );
+        return sock_errno_to_status( errno );
+    }
+
+    return finish_recv( async, &hdr, &unix_addr, ret, size );
+}
+
+#ifdef HAVE_RECVMMSG
+/* receive a datagram for a request and for the requests alerted along with it */
+static NTSTATUS try_recv_batch( int fd, struct async_recv_ioctl *async, ULONG_PTR *size )
+{
+    struct list *list, *ptr = &async->batch.entry;
+    unsigned int i, count = 0, max_count = min( async->io.batch + 1, MAX_IO_BATCH );
+    struct async_recv_ioctl *requests[MAX_IO_BATCH];
+    union unix_sockaddr unix_addrs[MAX_IO_BATCH];
+    char control_buffers[MAX_IO_BATCH][512];
+    struct mmsghdr msgs[MAX_IO_BATCH];
+    int ret;
+
+    if (list_empty( ptr )) return try_recv( fd, async, size );
+
+    list = &ntdll_get_thread_data()->sock_io->recvs[sock_io_bucket( async->io.handle )];
+    requests[count++] = async;
+    while (count < max_count && (ptr = list_next( list, ptr )))
+    {
+        struct async_recv_ioctl *next = LIST_ENTRY( ptr, struct async_recv_ioctl, batch.entry );
+
+        if (next->io.handle != async->io.handle) continue;
+        if (next->unix_flags != async->unix_flags || next->icmp_over_dgram) break;
+        requests[count++] = next;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        init_recv_msghdr( requests[i], &msgs[i].msg_hdr, &unix_addrs[i],
+                          control_buffers[i], sizeof(control_buffers[i]) );
+        msgs[i].msg_len = 0;
+    }
+
+    while ((ret = virtual_locked_recvmmsg( fd, msgs, count, async->unix_flags )) < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        /* let the plain path report the faulting buffer */
+        if (errno == EFAULT) return try_recv( fd, async, size );
+        if (errno != EWOULDBLOCK)
+        {
+            WARN( "recvmmsg: %s\n", strerror( errno ) );
+            return sock_errno_to_status( errno );
+        }
+        ret = 0;
+    }
+
+    for (i = 1; i < count; i++)
+    {
+        struct async_recv_ioctl *request = requests[i];
+
+        if (i < ret)
+        {
+            request->batch.status = finish_recv( request, &msgs[i].msg_hdr, &unix_addrs[i],
+                                                 msgs[i].msg_len, &request->batch.size );
+            request->batch.state = BATCH_DONE;
+        }
+        else request->batch.state = BATCH_EMPTY;
+    }
+
+    TRACE( "received %d of %u datagrams\n", ret, count );
+    if (!ret) return STATUS_DEVICE_NOT_READY;
+    return finish_recv( async, &msgs[0].msg_hdr, &unix_addrs[0], msgs[0].msg_len, size );
+}
+#endif
+
 static BOOL async_recv_proc( void *user, ULONG_PTR *info, unsigned int *status )
 {
     struct async_recv_ioctl *async = user;
@@ -818,18 +980,38 @@ static BOOL async_recv_proc( void *user, ULONG_PTR *info, unsigned int *status )
 
     TRACE( "%#x\n", *status );
 
-    if (*status == STATUS_ALERTED)
+    if (*status == STATUS_ALERTED && async->batch.state != BATCH_NONE)
+    {
+        BOOL done = (async->batch.state == BATCH_DONE);
+
+        async->batch.state = BATCH_NONE;
+        if (!done) return FALSE;
+        *status = async->batch.status;
+        *info = async->batch.size;
+        TRACE( "got status %#x, %#lx bytes read in batch\n", *status, *info );
+    }
+    else if (*status == STATUS_ALERTED)
     {
         if ((*status = server_get_unix_fd( async->io.handle, 0, &fd, &needs_close, NULL, NULL )))
+        {
+            list_remove( &async->batch.entry );
+            release_fileio( &async->io );
             return TRUE;
+        }
 
-        *status = try_recv( fd, async, info );
+#ifdef HAVE_RECVMMSG
+        if (async->io.batch && !async->icmp_over_dgram && !(async->unix_flags & (MSG_OOB | MSG_PEEK)))
+            *status = try_recv_batch( fd, async, info );
+        else
+#endif
+            *status = try_recv( fd, async, info );
         TRACE( "got status %#x, %#lx bytes read\n", *status, *info );
         if (needs_close) close( fd );
 
         if (*status == STATUS_DEVICE_NOT_READY)
             return FALSE;
     }
+    list_remove( &async->batch.entry );
     release_fileio( &async->io );
     return TRUE;
 }
@@ -854,6 +1036,9 @@ static BOOL is_icmp_over_dgram( int fd )
 static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
                            int fd, struct async_recv_ioctl *async, int force_async )
 {
+#ifdef HAVE_RECVMMSG
+    struct sock_io_lists *lists;
+#endif
     HANDLE wait_handle;
     BOOL nonblocking;
     unsigned int i, status;
@@ -867,6 +1052,8 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
             return STATUS_ACCESS_VIOLATION;
         }
     }
+    list_init( &async->batch.entry );
+    async->batch.state = BATCH_NONE;
 
     SERVER_START_REQ( recv_socket )
     {
@@ -898,7 +1085,14 @@ static NTSTATUS sock_recv( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         set_async_direct_result( &wait_handle, status, information, FALSE );
     }
 
-    if (status != STATUS_PENDING)
+#ifdef HAVE_RECVMMSG
+    /* the server only alerts datagram requests in batches, the others are never looked up */
+    if (status == STATUS_PENDING && (lists = get_sock_io_lists()))
+        list_add_tail( &lists->recvs[sock_io_bucket( handle )], &async->batch.entry );
+#endif
+    if (status == STATUS_PENDING)
+        set_sock_async( handle );
+    else
         release_fileio( &async->io );
 
     if (wait_handle) status = wait_async( wait_handle, options & FILE_SYNCHRONOUS_IO_ALERT );
@@ -982,6 +1176,22 @@ NTSTATUS sock_read( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc,
 }
 
 
+/* update the request after ret bytes of it have been sent */
+static NTSTATUS update_send_progress( struct async_send_ioctl *async, ssize_t ret )
+{
+    async->sent_len += ret;
+
+    while (async->iov_cursor < async->count && ret >= async->iov[async->iov_cursor].iov_len)
+        ret -= async->iov[async->iov_cursor++].iov_len;
+    if (async->iov_cursor < async->count)
+    {
+        async->iov[async->iov_cursor].iov_base = (char *)async->iov[async->iov_cursor].iov_base + ret;
+        async->iov[async->iov_cursor].iov_len -= ret;
+        return STATUS_DEVICE_NOT_READY;
+    }
+    return STATUS_SUCCESS;
+}
+
 static NTSTATUS try_send( int fd, struct async_send_ioctl *async )
 {
     union unix_sockaddr unix_addr;
@@ -1046,18 +1256,68 @@ static NTSTATUS try_send( int fd, struct async_send_ioctl *async )
         }
     }
 
-    async->sent_len += ret;
+    return update_send_progress( async, ret );
+}
 
-    while (async->iov_cursor < async->count && ret >= async->iov[async->iov_cursor].iov_len)
-        ret -= async->iov[async->iov_cursor++].iov_len;
-    if (async->iov_cursor < async->count)
+#ifdef HAVE_SENDMMSG
+/* send the datagram of a request and of the requests alerted along with it */
+static NTSTATUS try_send_batch( int fd, struct async_send_ioctl *async )
+{
+    struct list *list, *ptr = &async->batch.entry;
+    unsigned int i, count = 0, max_count = min( async->io.batch + 1, MAX_IO_BATCH );
+    struct async_send_ioctl *requests[MAX_IO_BATCH];
+    union unix_sockaddr unix_addrs[MAX_IO_BATCH];
+    struct mmsghdr msgs[MAX_IO_BATCH];
+    int ret;
+
+    if (list_empty( ptr )) return try_send( fd, async );
+
+    list = &ntdll_get_thread_data()->sock_io->sends[sock_io_bucket( async->io.handle )];
+    requests[count++] = async;
+    while (count < max_count && (ptr = list_next( list, ptr )))
     {
-        async->iov[async->iov_cursor].iov_base = (char *)async->iov[async->iov_cursor].iov_base + ret;
-        async->iov[async->iov_cursor].iov_len -= ret;
-        return STATUS_DEVICE_NOT_READY;
+        struct async_send_ioctl *next = LIST_ENTRY( ptr, struct async_send_ioctl, batch.entry );
+
+        if (next->io.handle != async->io.handle) continue;
+        if (next->unix_flags != async->unix_flags || next->iov_cursor) break;
+        requests[count++] = next;
     }
-    return STATUS_SUCCESS;
+
+    for (i = 0; i < count; i++)
+    {
+        struct async_send_ioctl *request = requests[i];
+        struct msghdr *hdr = &msgs[i].msg_hdr;
+
+        memset( hdr, 0, sizeof(*hdr) );
+        if (request->addr)
+        {
+            /* IPX needs the packet type fixup done in try_send() */
+            if (request->addr->sa_family == WS_AF_IPX) break;
+            hdr->msg_name = &unix_addrs[i];
+            if (!(hdr->msg_namelen = sockaddr_to_unix( request->addr, request->addr_len, &unix_addrs[i] )))
+                break;
+        }
+        hdr->msg_iov = request->iov;
+        hdr->msg_iovlen = request->count;
+        msgs[i].msg_len = 0;
+    }
+    count = i;
+
+    /* let the plain path report errors */
+    if (!count) return try_send( fd, async );
+    while ((ret = sendmmsg( fd, msgs, count, async->unix_flags )) < 0 && errno == EINTR);
+    if (ret <= 0) return try_send( fd, async );
+
+    for (i = 1; i < ret; i++)
+    {
+        requests[i]->batch.status = update_send_progress( requests[i], msgs[i].msg_len );
+        requests[i]->batch.state = BATCH_DONE;
+    }
+
+    TRACE( "sent %d of %u datagrams\n", ret, count );
+    return update_send_progress( async, msgs[0].msg_len );
 }
+#endif
 
 static void hack_update_status( HANDLE handle, unsigned int *status )
 {
@@ -1081,12 +1341,28 @@ static BOOL async_send_proc( void *user, ULONG_PTR *info, unsigned int *status )
 
     TRACE( "%#x\n", *status );
 
-    if (*status == STATUS_ALERTED)
+    if (*status == STATUS_ALERTED && async->batch.state == BATCH_DONE)
+    {
+        async->batch.state = BATCH_NONE;
+        *status = async->batch.status;
+        TRACE( "got status %#x in batch\n", *status );
+        hack_update_status( async->io.handle, status );
+    }
+    else if (*status == STATUS_ALERTED)
     {
         if ((*status = server_get_unix_fd( async->io.handle, 0, &fd, &needs_close, NULL, NULL )))
+        {
+            list_remove( &async->batch.entry );
+            release_fileio( &async->io );
             return TRUE;
+        }
 
-        *status = try_send( fd, async );
+#ifdef HAVE_SENDMMSG
+        if (async->io.batch && !async->iov_cursor)
+            *status = try_send_batch( fd, async );
+        else
+#endif
+            *status = try_send( fd, async );
         TRACE( "got status %#x\n", *status );
         hack_update_status( async->io.handle, status );
 
@@ -1096,6 +1372,7 @@ static BOOL async_send_proc( void *user, ULONG_PTR *info, unsigned int *status )
             return FALSE;
     }
     *info = async->sent_len;
+    list_remove( &async->batch.entry );
     release_fileio( &async->io );
     return TRUE;
 }
@@ -1128,11 +1405,17 @@ static void sock_save_icmp_id( struct async_send_ioctl *async )
 static NTSTATUS sock_send( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
                            IO_STATUS_BLOCK *io, int fd, struct async_send_ioctl *async, int force_async )
 {
+#ifdef HAVE_SENDMMSG
+    struct sock_io_lists *lists;
+#endif
     HANDLE wait_handle;
     BOOL nonblocking;
     unsigned int status;
     ULONG options;
 
+    list_init( &async->batch.entry );
+    async->batch.state = BATCH_NONE;
+
     SERVER_START_REQ( send_socket )
     {
         req->force_async = force_async;
@@ -1177,7 +1460,13 @@ static NTSTATUS sock_send( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         set_async_direct_result( &wait_handle, status, information, FALSE );
     }
 
-    if (status != STATUS_PENDING)
+#ifdef HAVE_SENDMMSG
+    if (status == STATUS_PENDING && (lists = get_sock_io_lists()))
+        list_add_tail( &lists->sends[sock_io_bucket( handle )], &async->batch.entry );
+#endif
+    if (status == STATUS_PENDING)
+        set_sock_async( handle );
+    else
         release_fileio( &async->io );
 
     if (wait_handle) status = wait_async( wait_handle, options & FILE_SYNCHRONOUS_IO_ALERT );
@@ -1233,7 +1522,7 @@ NTSTATUS sock_write( HANDLE handle, int fd, HANDLE event, PIO_APC_ROUTINE apc,
     static const DWORD async_size = offsetof( struct async_send_ioctl, iov[1] );
     struct async_send_ioctl *async;
 
-    if (!(async = (struct async_send_ioctl *)alloc_fileio( async_size, async_recv_proc, handle )))
+    if (!(async = (struct async_send_ioctl *)alloc_fileio( async_size, async_send_proc, handle )))
         return STATUS_NO_MEMORY;
 
     async->count = 1;
@@ -1282,10 +1571,50 @@ static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_io
         async->file_cursor += ret;
     }
 
+#ifdef HAVE_SYS_SENDFILE_H
+    /* send the file data straight from the page cache when possible */
+    while (async->file && !async->no_sendfile && async->buffer_cursor == async->read_len)
+    {
+        size_t count = 0x40000000;
+        off_t offset = async->offset.QuadPart;
+
+        if (async->file_len) count = min( count, async->file_len - async->file_cursor );
+
+        TRACE( "sending %zu bytes of file data with sendfile\n", count );
+        if (async->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+            ret = sendfile( sock_fd, file_fd, NULL, count );
+        else
+            ret = sendfile( sock_fd, file_fd, &offset, count );
+
+        if (ret < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EINVAL || errno == ENOSYS || errno == EOVERFLOW)
+            {
+                /* fall back to reading through the buffer */
+                async->no_sendfile = TRUE;
+                break;
+            }
+            if (errno != EWOULDBLOCK) WARN( "sendfile: %s\n", strerror( errno ) );
+            return sock_errno_to_status( errno );
+        }
+        TRACE( "sendfile returned %zd\n", ret );
+
+        async->file_cursor += ret;
+        if (async->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            async->offset.QuadPart += ret;
+        if (!ret || (async->file_len && async->file_cursor == async->file_len))
+            async->file = NULL;
+    }
+#endif
+
     if (async->file && async->buffer_cursor == async->read_len)
     {
         unsigned int read_size = async->buffer_size;
 
+        if (!async->buffer && !(async->buffer = malloc( async->buffer_size )))
+            return STATUS_NO_MEMORY;
+
         if (async->file_len)
             read_size = min( read_size, async->file_len - async->file_cursor );
 
@@ -1333,12 +1662,12 @@ static BOOL async_transmit_proc( void *user, ULONG_PTR *info, unsigned int *stat
     if (*status == STATUS_ALERTED)
     {
         if ((*status = server_get_unix_fd( async->io.handle, 0, &sock_fd, &sock_needs_close, NULL, NULL )))
-            return TRUE;
+            goto done;
 
         if (async->file && (*status = server_get_unix_fd( async->file, 0, &file_fd, &file_needs_close, NULL, NULL )))
         {
             if (sock_needs_close) close( sock_fd );
-            return TRUE;
+            goto done;
         }
 
         *status = try_transmit( sock_fd, file_fd, async );
@@ -1350,7 +1679,10 @@ static BOOL async_transmit_proc( void *user, ULONG_PTR *info, unsigned int *stat
         if (*status == STATUS_DEVICE_NOT_READY)
             return FALSE;
     }
+done:
+    /* the request is complete, whatever the reason */
     *info = async->head_cursor + async->file_cursor + async->tail_cursor;
+    free( async->buffer );
     release_fileio( &async->io );
     return TRUE;
 }
@@ -1389,11 +1721,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
 
     async->file = ULongToHandle( params->file );
     async->buffer_size = params->buffer_size ? params->buffer_size : 65536;
-    if (!(async->buffer = malloc( async->buffer_size )))
-    {
-        release_fileio( &async->io );
-        return STATUS_NO_MEMORY;
-    }
+    async->buffer = NULL;  /* allocated when sendfile() can't be used */
     async->read_len = 0;
     async->head_cursor = 0;
     async->file_cursor = 0;
@@ -1406,6 +1734,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     async->tail = u64_to_user_ptr(params->tail_ptr);
     async->tail_len = params->tail_len;
     async->offset = params->offset;
+    async->no_sendfile = FALSE;
 
     SERVER_START_REQ( send_socket )
     {
@@ -1439,7 +1768,10 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     }
 
     if (status != STATUS_PENDING)
+    {
+        free( async->buffer );
         release_fileio( &async->io );
+    }
 
     if (!status && !(options & (FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT)))
     {
@@ -1466,6 +1798,152 @@ static void complete_async( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
 }
 
 
+/* Try to complete a synchronous poll without going through the server.  This
+ * is only done for listening and connectionless sockets, whose Unix state maps
+ * to poll flags without knowing the server side state.  Otherwise (connection
+ * oriented sockets, sockets with queued asynchronous requests, errors,
+ * hangups, urgent data) and when a non-zero timeout would have to wait, we
+ * return STATUS_BAD_DEVICE_TYPE to let the server handle the request. */
+static NTSTATUS sock_poll( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user, IO_STATUS_BLOCK *io,
+                           const void *in_buffer, UINT in_size, void *out_buffer, UINT out_size )
+{
+    static const int supported_flags = AFD_POLL_READ | AFD_POLL_OOB | AFD_POLL_WRITE | AFD_POLL_HUP |
+                                       AFD_POLL_RESET | AFD_POLL_ACCEPT | AFD_POLL_CONNECT_ERR;
+    const struct afd_poll_params_64 *params64 = in_buffer;
+    const struct afd_poll_params_32 *params32 = in_buffer;
+    BOOL wow64 = in_wow64_call();
+    unsigned int i, count, signaled = 0;
+    unsigned int opened = 0;
+    NTSTATUS status = STATUS_BAD_DEVICE_TYPE;
+    struct pollfd *pollfds;
+    ULONG_PTR output_size;
+    BOOLEAN exclusive;
+    LONGLONG timeout;
+    int *flags, *needs_close;
+
+    if (apc || apc_user) return STATUS_BAD_DEVICE_TYPE;
+
+    if (wow64)
+    {
+        if (in_size < sizeof(*params32) || in_size < offsetof( struct afd_poll_params_32, sockets[params32->count] ))
+            return STATUS_BAD_DEVICE_TYPE;
+        count = params32->count;
+        timeout = params32->timeout;
+        exclusive = params32->exclusive;
+    }
+    else
+    {
+        if (in_size < sizeof(*params64) || in_size < offsetof( struct afd_poll_params_64, sockets[params64->count] ))
+            return STATUS_BAD_DEVICE_TYPE;
+        count = params64->count;
+        timeout = params64->timeout;
+        exclusive = params64->exclusive;
+    }
+    if (!count || exclusive) return STATUS_BAD_DEVICE_TYPE;
+
+    if (!(pollfds = malloc( count * (sizeof(*pollfds) + 2 * sizeof(int)) ))) return STATUS_BAD_DEVICE_TYPE;
+    flags = (int *)(pollfds + count);
+    needs_close = flags + count;
+
+    for (i = 0; i < count; ++i)
+    {
+        HANDLE socket = wow64 ? ULongToHandle( params32->sockets[i].socket ) : (HANDLE)(ULONG_PTR)params64->sockets[i].socket;
+        int mask = wow64 ? params32->sockets[i].flags : params64->sockets[i].flags;
+        enum server_fd_type type;
+
+        if (mask & ~supported_flags) goto done;
+        if (has_sock_async( socket )) goto done;
+        if (server_get_unix_fd( socket, 0, &pollfds[i].fd, &needs_close[i], &type, NULL )) goto done;
+        opened++;
+        if (type != FD_TYPE_SOCKET) goto done;
+
+        pollfds[i].events = 0;
+        if (mask & (AFD_POLL_READ | AFD_POLL_ACCEPT | AFD_POLL_HUP)) pollfds[i].events |= POLLIN;
+        if (mask & AFD_POLL_OOB) pollfds[i].events |= POLLPRI;
+        if (mask & AFD_POLL_WRITE) pollfds[i].events |= POLLOUT;
+        flags[i] = mask;
+    }
+
+    if (poll( pollfds, count, 0 ) < 0) goto done;
+
+    for (i = 0; i < count; ++i)
+    {
+        int mask = flags[i], revents = pollfds[i].revents, value;
+        socklen_t len = sizeof(value);
+
+        flags[i] = 0;
+        if (!revents) continue;
+        if (revents & (POLLERR | POLLHUP | POLLNVAL | POLLPRI)) goto done;
+        if (getsockopt( pollfds[i].fd, SOL_SOCKET, SO_TYPE, &value, &len )) goto done;
+
+        if (value == SOCK_STREAM)
+        {
+            /* only the server knows whether a connection has completed, or whether the
+             * end of stream has been reported; leave all but listening sockets to it */
+            len = sizeof(value);
+            if (getsockopt( pollfds[i].fd, SOL_SOCKET, SO_ACCEPTCONN, &value, &len ) || !value) goto done;
+            if (revents & POLLIN) flags[i] |= AFD_POLL_ACCEPT;
+        }
+        else
+        {
+            if (revents & POLLIN) flags[i] |= AFD_POLL_READ;
+            if (revents & POLLOUT) flags[i] |= AFD_POLL_WRITE;
+        }
+        if ((flags[i] &= mask)) ++signaled;
+    }
+
+    if (!signaled && timeout) goto done;
+
+    output_size = wow64 ? offsetof( struct afd_poll_params_32, sockets[signaled] )
+                        : offsetof( struct afd_poll_params_64, sockets[signaled] );
+    if (out_size < output_size) goto done;
+
+    if (wow64)
+    {
+        struct afd_poll_params_32 *output = out_buffer;
+        unsigned int j = 0;
+
+        for (i = 0; i < count; ++i)
+        {
+            if (!flags[i]) continue;
+            output->sockets[j].socket = params32->sockets[i].socket;
+            output->sockets[j].flags = flags[i];
+            output->sockets[j].status = STATUS_SUCCESS;
+            ++j;
+        }
+        output->timeout = timeout;
+        output->count = signaled;
+        output->exclusive = exclusive;
+    }
+    else
+    {
+        struct afd_poll_params_64 *output = out_buffer;
+        unsigned int j = 0;
+
+        for (i = 0; i < count; ++i)
+        {
+            if (!flags[i]) continue;
+            output->sockets[j].socket = params64->sockets[i].socket;
+            output->sockets[j].flags = flags[i];
+            output->sockets[j].status = STATUS_SUCCESS;
+            ++j;
+        }
+        output->timeout = timeout;
+        output->count = signaled;
+        output->exclusive = exclusive;
+    }
+
+    TRACE( "%u of %u sockets signaled\n", signaled, count );
+    complete_async( handle, event, apc, apc_user, io, STATUS_SUCCESS, output_size );
+    status = STATUS_SUCCESS;
+
+done:
+    for (i = 0; i < opened; ++i) if (needs_close[i]) close( pollfds[i].fd );
+    free( pollfds );
+    return status;
+}
+
+
 static NTSTATUS do_getsockopt( HANDLE handle, IO_STATUS_BLOCK *io, int level,
                                int option, void *out_buffer, ULONG out_size )
 {
@@ -1573,10 +2051,16 @@ NTSTATUS sock_ioctl( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, void *apc
             status = STATUS_BAD_DEVICE_TYPE;
             break;
 
-        case IOCTL_AFD_POLL:
+        case IOCTL_AFD_WINE_ACCEPT:
+        case IOCTL_AFD_WINE_ACCEPT_INTO:
+            /* handled by the server, but later polls must see the accept request */
+            set_sock_async( handle );
             status = STATUS_BAD_DEVICE_TYPE;
             break;
 
+        case IOCTL_AFD_POLL:
+            return sock_poll( handle, event, apc, apc_user, io, in_buffer, in_size, out_buffer, out_size );
+
         case IOCTL_AFD_RECV:
         {
             struct afd_recv_params params;
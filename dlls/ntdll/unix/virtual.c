@@ -158,6 +158,7 @@ static pthread_mutex_t virtual_mutex;
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
 static const UINT_PTR granularity_mask = 0xffff;
+static const UINT_PTR large_page_mask = 0x1fffff;
 
 /* Note: these are Windows limits, you cannot change them. */
 #ifdef __i386__
@@ -206,6 +207,10 @@ static struct list teb_list = LIST_INIT( teb_list );
 #ifdef _WIN64  /* on 64-bit the page protection bytes use a 2-level table */
 static const size_t pages_vprot_shift = 20;
 static const size_t pages_vprot_mask = (1 << 20) - 1;
+/* each table is split into blocks that are stored as a single value while all their pages are equal */
+static const size_t pages_vprot_block_shift = 9;
+static const size_t pages_vprot_block_mask = (1 << 9) - 1;
+#define VPROT_BLOCK_UNIFORM 0x100
 static size_t pages_vprot_size;
 static BYTE **pages_vprot;
 #else  /* on 32-bit we use a simple array with one byte per page */
@@ -213,6 +218,7 @@ static BYTE *pages_vprot;
 #endif
 
 static BOOL use_kernel_writewatch;
+static SIZE_T hugepage_min_size;  /* minimum size of views backed by transparent huge pages */
 static int pagemap_fd, pagemap_reset_fd, clear_refs_fd;
 #define PAGE_FLAGS_BUFFER_LENGTH 1024
 #define PM_SOFT_DIRTY_PAGE (1ull << 57)
@@ -913,6 +919,38 @@ static inline int is_view_valloc( const struct file_view *view )
     return !(view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT));
 }
 
+#ifdef _WIN64
+/***********************************************************************
+ *           get_vprot_block
+ *
+ * Return the block descriptor for a page index. The table must be allocated.
+ */
+static inline USHORT *get_vprot_block( size_t idx )
+{
+    USHORT *blocks = (USHORT *)(pages_vprot[idx >> pages_vprot_shift] + pages_vprot_mask + 1);
+    return blocks + ((idx & pages_vprot_mask) >> pages_vprot_block_shift);
+}
+
+/***********************************************************************
+ *           get_vprot_ptr
+ *
+ * Return the protection byte for a page index, expanding its block if needed
+ * so that the pages can be modified individually.
+ */
+static BYTE *get_vprot_ptr( size_t idx )
+{
+    BYTE *ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
+    USHORT *block = get_vprot_block( idx );
+
+    if (*block & VPROT_BLOCK_UNIFORM)
+    {
+        memset( ptr - (idx & pages_vprot_block_mask), *block, pages_vprot_block_mask + 1 );
+        *block = 0;
+    }
+    return ptr;
+}
+#endif
+
 /***********************************************************************
  *           get_page_vprot
  *
@@ -923,8 +961,11 @@ static BYTE get_page_vprot( const void *addr )
     size_t idx = (size_t)addr >> page_shift;
 
 #ifdef _WIN64
+    USHORT block;
+
     if ((idx >> pages_vprot_shift) >= pages_vprot_size) return 0;
     if (!pages_vprot[idx >> pages_vprot_shift]) return 0;
+    if ((block = *get_vprot_block( idx )) & VPROT_BLOCK_UNIFORM) return block;
     return pages_vprot[idx >> pages_vprot_shift][idx & pages_vprot_mask];
 #else
     return pages_vprot[idx];
@@ -944,7 +985,7 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
 {
     static const UINT_PTR word_from_byte = (UINT_PTR)0x101010101010101;
     static const UINT_PTR index_align_mask = sizeof(UINT_PTR) - 1;
-    SIZE_T curr_idx, start_idx, end_idx, aligned_start_idx;
+    SIZE_T curr_idx, start_idx, end_idx;
     UINT_PTR vprot_word, mask_word;
     const BYTE *vprot_ptr;
 
@@ -953,37 +994,59 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
     curr_idx = start_idx = (size_t)base >> page_shift;
     end_idx = start_idx + (size >> page_shift);
 
-    aligned_start_idx = (start_idx + index_align_mask) & ~index_align_mask;
-    if (aligned_start_idx > end_idx) aligned_start_idx = end_idx;
+    *vprot = get_page_vprot( base );
+    vprot_word = word_from_byte * *vprot;
+    mask_word = word_from_byte * mask;
 
 #ifdef _WIN64
-    vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift] + (curr_idx & pages_vprot_mask);
+    while (curr_idx < end_idx)
+    {
+        USHORT block = *get_vprot_block( curr_idx );
+        SIZE_T block_end = min( (curr_idx | pages_vprot_block_mask) + 1, end_idx );
+
+        if (block & VPROT_BLOCK_UNIFORM)
+        {
+            if ((*vprot ^ block) & mask) break;
+            curr_idx = block_end;
+            continue;
+        }
+
+        /* blocks are aligned so the word accesses never cross a table boundary */
+        vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift] + (curr_idx & pages_vprot_mask);
+        for (; curr_idx < block_end && (curr_idx & index_align_mask); ++curr_idx, ++vprot_ptr)
+            if ((*vprot ^ *vprot_ptr) & mask) goto done;
+        for (; curr_idx + sizeof(UINT_PTR) <= block_end; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
+            if ((vprot_word ^ *(UINT_PTR *)vprot_ptr) & mask_word) break;
+        for (; curr_idx < block_end; ++curr_idx, ++vprot_ptr)
+            if ((*vprot ^ *vprot_ptr) & mask) goto done;
+    }
+done:
+    return (curr_idx - start_idx) << page_shift;
 #else
-    vprot_ptr = pages_vprot + curr_idx;
-#endif
-    *vprot = *vprot_ptr;
+    {
+        SIZE_T aligned_start_idx = (start_idx + index_align_mask) & ~index_align_mask;
+        if (aligned_start_idx > end_idx) aligned_start_idx = end_idx;
 
-    /* Page count page table is at least the multiples of sizeof(UINT_PTR)
-     * so we don't have to worry about crossing the boundary on unaligned idx values. */
+        vprot_ptr = pages_vprot + curr_idx;
 
-    for (; curr_idx < aligned_start_idx; ++curr_idx, ++vprot_ptr)
-        if ((*vprot ^ *vprot_ptr) & mask) return (curr_idx - start_idx) << page_shift;
+        /* Page count page table is at least the multiples of sizeof(UINT_PTR)
+         * so we don't have to worry about crossing the boundary on unaligned idx values. */
 
-    vprot_word = word_from_byte * *vprot;
-    mask_word = word_from_byte * mask;
-    for (; curr_idx < end_idx; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
-    {
-#ifdef _WIN64
-        if (!(curr_idx & pages_vprot_mask)) vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift];
-#endif
-        if ((vprot_word ^ *(UINT_PTR *)vprot_ptr) & mask_word)
+        for (; curr_idx < aligned_start_idx; ++curr_idx, ++vprot_ptr)
+            if ((*vprot ^ *vprot_ptr) & mask) return (curr_idx - start_idx) << page_shift;
+
+        for (; curr_idx < end_idx; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
         {
-            for (; curr_idx < end_idx; ++curr_idx, ++vprot_ptr)
-                if ((*vprot ^ *vprot_ptr) & mask) break;
-            return (curr_idx - start_idx) << page_shift;
+            if ((vprot_word ^ *(UINT_PTR *)vprot_ptr) & mask_word)
+            {
+                for (; curr_idx < end_idx; ++curr_idx, ++vprot_ptr)
+                    if ((*vprot ^ *vprot_ptr) & mask) break;
+                return (curr_idx - start_idx) << page_shift;
+            }
         }
+        return size;
     }
-    return size;
+#endif
 }
 
 /***********************************************************************
@@ -997,13 +1060,19 @@ static void set_page_vprot( const void *addr, size_t size, BYTE vprot )
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    while (idx >> pages_vprot_shift != end >> pages_vprot_shift)
+    while (idx < end)
     {
-        size_t dir_size = pages_vprot_mask + 1 - (idx & pages_vprot_mask);
-        memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, dir_size );
-        idx += dir_size;
+        size_t block_end = (idx | pages_vprot_block_mask) + 1;
+
+        if (!(idx & pages_vprot_block_mask) && block_end <= end)
+            *get_vprot_block( idx ) = VPROT_BLOCK_UNIFORM | vprot;
+        else
+        {
+            if (block_end > end) block_end = end;
+            memset( get_vprot_ptr( idx ), vprot, block_end - idx );
+        }
+        idx = block_end;
     }
-    memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, end - idx );
 #else
     memset( pages_vprot + idx, vprot, end - idx );
 #endif
@@ -1021,10 +1090,20 @@ static void set_page_vprot_bits( const void *addr, size_t size, BYTE set, BYTE c
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    for ( ; idx < end; idx++)
+    while (idx < end)
     {
-        BYTE *ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
-        *ptr = (*ptr & ~clear) | set;
+        size_t block_end = (idx | pages_vprot_block_mask) + 1;
+        USHORT *block = get_vprot_block( idx );
+        BYTE *ptr;
+
+        if (!(idx & pages_vprot_block_mask) && block_end <= end && (*block & VPROT_BLOCK_UNIFORM))
+        {
+            *block = VPROT_BLOCK_UNIFORM | (((BYTE)*block & ~clear) | set);
+            idx = block_end;
+            continue;
+        }
+        if (block_end > end) block_end = end;
+        for (ptr = get_vprot_ptr( idx ); idx < block_end; idx++, ptr++) *ptr = (*ptr & ~clear) | set;
     }
 #else
     for ( ; idx < end; idx++) pages_vprot[idx] = (pages_vprot[idx] & ~clear) | set;
@@ -1042,15 +1121,20 @@ static BOOL alloc_pages_vprot( const void *addr, size_t size )
 #ifdef _WIN64
     size_t idx = (size_t)addr >> page_shift;
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
-    size_t i;
+    size_t i, j, block_count = (pages_vprot_mask + 1) >> pages_vprot_block_shift;
+    USHORT *blocks;
     void *ptr;
 
     assert( end <= pages_vprot_size << pages_vprot_shift );
     for (i = idx >> pages_vprot_shift; i < (end + pages_vprot_mask) >> pages_vprot_shift; i++)
     {
         if (pages_vprot[i]) continue;
-        if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) == MAP_FAILED)
+        if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1 + block_count * sizeof(*blocks),
+                                    PROT_READ | PROT_WRITE )) == MAP_FAILED)
             return FALSE;
+        /* start with uniform blocks, so that the page bytes are only touched when needed */
+        blocks = (USHORT *)((BYTE *)ptr + pages_vprot_mask + 1);
+        for (j = 0; j < block_count; j++) blocks[j] = VPROT_BLOCK_UNIFORM;
         pages_vprot[i] = ptr;
     }
 #endif
@@ -1661,22 +1745,27 @@ static inline int mprotect_exec( void *base, size_t size, int unix_prot )
  */
 static void mprotect_range( void *base, size_t size, BYTE set, BYTE clear )
 {
-    size_t i, count;
     char *addr = ROUND_ADDR( base, page_mask );
-    int prot, next;
+    size_t count = 0, run;
+    int prot = 0, next;
+    BYTE vprot;
 
     size = ROUND_SIZE( base, size );
-    prot = get_unix_prot( (get_page_vprot( addr ) & ~clear ) | set );
-    for (count = i = 1; i < size >> page_shift; i++, count++)
+    while (size)
     {
-        next = get_unix_prot( (get_page_vprot( addr + (count << page_shift) ) & ~clear) | set );
-        if (next == prot) continue;
-        mprotect_exec( addr, count << page_shift, prot );
-        addr += count << page_shift;
+        run = get_vprot_range_size( addr + count, size, 0xff, &vprot );
+        next = get_unix_prot( (vprot & ~clear) | set );
+        if (count && next != prot)
+        {
+            mprotect_exec( addr, count, prot );
+            addr += count;
+            count = 0;
+        }
         prot = next;
-        count = 0;
+        count += run;
+        size -= run;
     }
-    if (count) mprotect_exec( addr, count << page_shift, prot );
+    if (count) mprotect_exec( addr, count, prot );
 }
 
 
@@ -1722,6 +1811,8 @@ static NTSTATUS set_protection( struct file_view *view, void *base, SIZE_T size,
         BYTE access = vprot & (VPROT_READ | VPROT_WRITE | VPROT_EXEC);
         if ((view->protect & access) != access) return STATUS_INVALID_PAGE_PROTECTION;
     }
+    if ((view->protect & SEC_LARGE_PAGES) && (((UINT_PTR)base | size) & large_page_mask))
+        return STATUS_INVALID_PARAMETER;
 
     if (!set_vprot( view, base, size, vprot | VPROT_COMMITTED )) return STATUS_ACCESS_DENIED;
     return STATUS_SUCCESS;
@@ -2313,6 +2404,8 @@ static SIZE_T get_committed_size( struct file_view *view, void *base, BYTE *vpro
 static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t size )
 {
     if (!size) size = view->size;
+    /* huge pages can only be replaced as a whole */
+    if ((view->protect & SEC_LARGE_PAGES) && ((start | size) & large_page_mask)) return STATUS_INVALID_PARAMETER;
     if (anon_mmap_fixed( (char *)view->base + start, size, PROT_NONE, 0 ) != MAP_FAILED)
     {
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
@@ -2322,6 +2415,70 @@ static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t siz
 }
 
 
+/***********************************************************************
+ *           advise_huge_pages
+ *
+ * Ask the kernel to back the large page aligned part of a range with transparent huge pages.
+ */
+static void advise_huge_pages( void *base, size_t size )
+{
+#ifdef MADV_HUGEPAGE
+    char *start = (char *)(((UINT_PTR)base + large_page_mask) & ~large_page_mask);
+    char *end = ROUND_ADDR( (char *)base + size, large_page_mask );
+
+    if (start < end) madvise( start, end - start, MADV_HUGEPAGE );
+#endif
+}
+
+
+/***********************************************************************
+ *           has_lock_memory_privilege
+ *
+ * Check whether SeLockMemoryPrivilege, required for MEM_LARGE_PAGES, is enabled.
+ */
+static BOOL has_lock_memory_privilege(void)
+{
+    PRIVILEGE_SET privs;
+    HANDLE token;
+    BOOLEAN ret = FALSE;
+
+    if (NtOpenThreadToken( GetCurrentThread(), TOKEN_QUERY, TRUE, &token ) &&
+        NtOpenProcessToken( GetCurrentProcess(), TOKEN_QUERY, &token ))
+        return FALSE;
+
+    privs.PrivilegeCount = 1;
+    privs.Control = PRIVILEGE_SET_ALL_NECESSARY;
+    privs.Privilege[0].Luid.LowPart = SE_LOCK_MEMORY_PRIVILEGE;
+    privs.Privilege[0].Luid.HighPart = 0;
+    privs.Privilege[0].Attributes = 0;
+    if (NtPrivilegeCheck( token, &privs, &ret )) ret = FALSE;
+    NtClose( token );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           map_large_pages
+ *
+ * Replace the pages of a newly allocated view by huge pages, for MEM_LARGE_PAGES.
+ * virtual_mutex must be held by caller.
+ */
+static NTSTATUS map_large_pages( struct file_view *view, unsigned int vprot )
+{
+#ifdef MAP_HUGETLB
+    if (mmap( view->base, view->size, get_unix_prot( vprot ), MAP_PRIVATE | MAP_ANON | MAP_FIXED | MAP_HUGETLB,
+              -1, 0 ) != MAP_FAILED)
+    {
+        view->protect |= SEC_LARGE_PAGES;
+        return STATUS_SUCCESS;
+    }
+    WARN( "no huge pages available for %p-%p, error %s\n",
+          view->base, (char *)view->base + view->size, strerror(errno) );
+#endif
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+
 /***********************************************************************
  *           allocate_dos_memory
  *
@@ -2410,6 +2567,122 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
 }
 
 
+/* size of the memory range taken by an image section that has file data, 0 if it doesn't have any */
+static SIZE_T get_reloc_section_size( const IMAGE_SECTION_HEADER *sec )
+{
+    if (!sec->PointerToRawData || !sec->SizeOfRawData) return 0;
+    if ((sec->Characteristics & IMAGE_SCN_MEM_SHARED) && (sec->Characteristics & IMAGE_SCN_MEM_WRITE)) return 0;
+    return ROUND_SIZE( 0, sec->Misc.VirtualSize ? sec->Misc.VirtualSize : sec->SizeOfRawData );
+}
+
+
+/***********************************************************************
+ *           fill_reloc_image_file
+ *
+ * Copy an image mapped in a view into the shared relocated image file, and relocate it
+ * to the view address. Returns FALSE if the image can't be relocated there.
+ * virtual_mutex must be held by caller.
+ */
+static BOOL fill_reloc_image_file( struct file_view *view, int fd, SIZE_T header_size,
+                                   const IMAGE_SECTION_HEADER *sections, UINT nb_sections )
+{
+    const IMAGE_BASE_RELOCATION *rel, *end;
+    IMAGE_DATA_DIRECTORY *dir;
+    IMAGE_NT_HEADERS *nt;
+    ULONGLONG image_base;
+    char *copy;
+    BOOL ret = FALSE;
+    INT_PTR delta;
+    UINT i;
+
+    if ((copy = mmap( NULL, view->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 )) == MAP_FAILED)
+        return FALSE;
+
+    memcpy( copy, view->base, ROUND_SIZE( 0, header_size ));
+    for (i = 0; i < nb_sections; i++)
+    {
+        SIZE_T size = get_reloc_section_size( &sections[i] );
+        if (size) memcpy( copy + sections[i].VirtualAddress, (char *)view->base + sections[i].VirtualAddress, size );
+    }
+
+    nt = (IMAGE_NT_HEADERS *)(copy + ((IMAGE_DOS_HEADER *)copy)->e_lfanew);
+    if (nt->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+    {
+        IMAGE_NT_HEADERS64 *nt64 = (IMAGE_NT_HEADERS64 *)nt;
+        if (nt64->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_BASERELOC) goto done;
+        dir = &nt64->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        image_base = nt64->OptionalHeader.ImageBase;
+        nt64->OptionalHeader.ImageBase = (ULONG_PTR)view->base;
+    }
+    else
+    {
+        IMAGE_NT_HEADERS32 *nt32 = (IMAGE_NT_HEADERS32 *)nt;
+        if (nt32->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_BASERELOC) goto done;
+        if ((ULONG_PTR)view->base != (ULONG)(ULONG_PTR)view->base) goto done;
+        dir = &nt32->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+        image_base = nt32->OptionalHeader.ImageBase;
+        nt32->OptionalHeader.ImageBase = (ULONG_PTR)view->base;
+    }
+
+    if (!dir->Size || !dir->VirtualAddress) goto done;
+    if (dir->VirtualAddress >= view->size || dir->Size > view->size - dir->VirtualAddress) goto done;
+
+    rel = (const IMAGE_BASE_RELOCATION *)(copy + dir->VirtualAddress);
+    end = (const IMAGE_BASE_RELOCATION *)(copy + dir->VirtualAddress + dir->Size);
+    delta = (ULONG_PTR)view->base - image_base;
+
+    while (rel < end - 1 && rel->SizeOfBlock)
+    {
+        /* relocations can touch up to 8 bytes past the 4k block they apply to */
+        if (rel->VirtualAddress > view->size - 0x1000 - sizeof(INT64)) goto done;
+        if (rel->SizeOfBlock < sizeof(*rel) || rel->SizeOfBlock > (char *)end - (char *)rel) goto done;
+        /* the fixups must land in pages that are mapped from the relocated file */
+        if (rel->VirtualAddress >= ROUND_SIZE( 0, header_size ))
+        {
+            for (i = 0; i < nb_sections; i++)
+                if (rel->VirtualAddress >= sections[i].VirtualAddress &&
+                    rel->VirtualAddress < sections[i].VirtualAddress + get_reloc_section_size( &sections[i] ))
+                    break;
+            if (i == nb_sections) goto done;
+        }
+        if (!(rel = process_relocation_block( copy, rel, delta ))) goto done;
+    }
+    ret = TRUE;
+
+done:
+    munmap( copy, view->size );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           map_reloc_image_file
+ *
+ * Replace the image header and sections mapped in a view by the ones of the
+ * relocated image file, so that their pages are shared with other processes.
+ * virtual_mutex must be held by caller.
+ */
+static NTSTATUS map_reloc_image_file( struct file_view *view, int fd, SIZE_T header_size,
+                                      const IMAGE_SECTION_HEADER *sections, UINT nb_sections )
+{
+    unsigned int vprot = VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY;
+    NTSTATUS status;
+    UINT i;
+
+    if ((status = map_file_into_view( view, fd, 0, ROUND_SIZE( 0, header_size ), 0, vprot, FALSE )))
+        return status;
+
+    for (i = 0; i < nb_sections; i++)
+    {
+        SIZE_T size = get_reloc_section_size( &sections[i] );
+        if (size && (status = map_file_into_view( view, fd, sections[i].VirtualAddress, size,
+                                                  sections[i].VirtualAddress, vprot, FALSE )))
+            return status;
+    }
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           map_image_into_view
  *
@@ -2417,7 +2690,8 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
  * virtual_mutex must be held by caller.
  */
 static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filename, int fd, void *orig_base,
-                                     SIZE_T header_size, ULONG image_flags, int shared_fd, BOOL removable )
+                                     SIZE_T header_size, ULONG image_flags, int shared_fd, BOOL removable,
+                                     int reloc_fd, BOOL reloc_ready, BOOL *relocated )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -2574,6 +2848,18 @@ static NTSTATUS map_image_into_view( struct file_view *view, const WCHAR *filena
         }
     }
 
+    /* use the pages of the image relocated to this address, if available */
+
+    if (reloc_fd != -1 && (reloc_ready || fill_reloc_image_file( view, reloc_fd, header_size, sections,
+                                                                 nt->FileHeader.NumberOfSections )))
+    {
+        if ((status = map_reloc_image_file( view, reloc_fd, header_size, sections,
+                                            nt->FileHeader.NumberOfSections )))
+            return status;
+        TRACE_(module)( "using %s relocated image for %s\n", reloc_ready ? "cached" : "new", debugstr_w(filename) );
+        *relocated = TRUE;
+    }
+
     /* set the image protections */
 
     set_vprot( view, ptr, ROUND_SIZE( 0, header_size ), VPROT_COMMITTED | VPROT_READ );
@@ -2665,8 +2951,11 @@ static NTSTATUS virtual_map_image( HANDLE mapping, ACCESS_MASK access, void **ad
     unsigned int vprot = SEC_IMAGE | SEC_FILE | VPROT_COMMITTED | VPROT_READ | VPROT_EXEC | VPROT_WRITECOPY;
     int unix_fd = -1, needs_close;
     int shared_fd = -1, shared_needs_close = 0;
+    int reloc_fd = -1, reloc_needs_close = 0;
     SIZE_T size = image_info->map_size;
     struct file_view *view;
+    HANDLE reloc_file = 0;
+    BOOL reloc_ready = FALSE, relocated = FALSE;
     unsigned int status;
     sigset_t sigset;
     void *base;
@@ -2699,8 +2988,45 @@ static NTSTATUS virtual_map_image( HANDLE mapping, ACCESS_MASK access, void **ad
     if (status) status = map_view( &view, NULL, size, alloc_type & MEM_TOP_DOWN, vprot, get_zero_bits_mask( zero_bits ), 0 );
     if (status) goto done;
 
+    /* relocated DLLs get their pages from a copy shared with the other processes using the same address */
+    if ((ULONG_PTR)view->base != image_info->base && !shared_file &&
+        (image_info->image_charact & IMAGE_FILE_DLL) &&
+        !(image_info->image_charact & IMAGE_FILE_RELOCS_STRIPPED) &&
+        !(image_info->image_flags & IMAGE_FLAGS_ImageMappedFlat))
+    {
+        SERVER_START_REQ( get_image_reloc_file )
+        {
+            req->mapping = wine_server_obj_handle( mapping );
+            req->base    = wine_server_client_ptr( view->base );
+            if (!wine_server_call( req ))
+            {
+                reloc_file  = wine_server_ptr_handle( reply->file );
+                reloc_ready = reply->ready;
+            }
+        }
+        SERVER_END_REQ;
+
+        if (reloc_file && server_get_unix_fd( reloc_file, reloc_ready ? FILE_READ_DATA : FILE_READ_DATA | FILE_WRITE_DATA,
+                                              &reloc_fd, &reloc_needs_close, NULL, NULL ))
+            reloc_fd = -1;
+    }
+
     status = map_image_into_view( view, filename, unix_fd, base, image_info->header_size,
-                                  image_info->image_flags, shared_fd, needs_close );
+                                  image_info->image_flags, shared_fd, needs_close,
+                                  reloc_fd, reloc_ready, &relocated );
+
+    if (reloc_file && !reloc_ready)
+    {
+        SERVER_START_REQ( set_image_reloc_file )
+        {
+            req->mapping = wine_server_obj_handle( mapping );
+            req->base    = wine_server_client_ptr( view->base );
+            req->success = relocated && !status;
+            wine_server_call( req );
+        }
+        SERVER_END_REQ;
+    }
+
     if (status == STATUS_SUCCESS)
     {
         SERVER_START_REQ( map_view )
@@ -2726,6 +3052,8 @@ done:
     server_leave_uninterrupted_section( &virtual_mutex, &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (reloc_needs_close) close( reloc_fd );
+    if (reloc_file) NtClose( reloc_file );
     return status;
 }
 
@@ -2922,6 +3250,13 @@ void virtual_init(void)
             MESSAGE("wine: using kernel write watches (experimental).\n");
     }
 
+    if ((env_var = getenv("WINE_HUGEPAGE_MIN_SIZE")))
+    {
+        /* size in megabytes above which anonymous allocations use transparent huge pages */
+        hugepage_min_size = (SIZE_T)atoi( env_var ) << 20;
+        TRACE("using transparent huge pages for allocations >= %p.\n", (void *)hugepage_min_size);
+    }
+
     if (preload_info && *preload_info)
         for (i = 0; (*preload_info)[i].size; i++)
             mmap_add_reserved_area( (*preload_info)[i].addr, (*preload_info)[i].size );
@@ -3181,6 +3516,7 @@ static TEB *init_teb( void *ptr, BOOL is_wow )
     thread_data = (struct ntdll_thread_data *)&teb->GdiTebBatch;
     thread_data->esync_apc_fd = -1;
     thread_data->fsync_apc_futex = NULL;
+    thread_data->sock_io = NULL;
     thread_data->request_fd = -1;
     thread_data->reply_fd   = -1;
     thread_data->wait_fd[0] = -1;
@@ -3304,6 +3640,7 @@ void virtual_free_teb( TEB *teb )
         size = 0;
         NtFreeVirtualMemory( GetCurrentProcess(), &ptr, &size, MEM_RELEASE );
     }
+    free( thread_data->sock_io );
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
     list_remove( &thread_data->entry );
@@ -3776,6 +4113,64 @@ ssize_t virtual_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
 }
 
 
+#ifdef HAVE_RECVMMSG
+/***********************************************************************
+ *           virtual_locked_recvmmsg
+ *
+ * A datagram that faults is dropped by the kernel, so unlike recvmsg() the
+ * buffers have to be made writable before the call instead of on EFAULT.
+ */
+int virtual_locked_recvmmsg( int fd, struct mmsghdr *msgs, unsigned int count, int flags )
+{
+    sigset_t sigset;
+    unsigned int i;
+    size_t j, len;
+    BOOL has_write_watch = FALSE;
+    int ret = -1, err = EFAULT;
+
+    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    for (i = 0; i < count; i++)
+    {
+        struct msghdr *hdr = &msgs[i].msg_hdr;
+
+        for (j = 0; j < hdr->msg_iovlen; j++)
+            if (check_write_access( hdr->msg_iov[j].iov_base, hdr->msg_iov[j].iov_len, &has_write_watch ))
+                break;
+        if (j < hdr->msg_iovlen) break;
+    }
+    if (i == count)
+    {
+        ret = recvmmsg( fd, msgs, count, flags, NULL );
+        err = errno;
+    }
+    if (has_write_watch)
+    {
+        if (i < count)  /* the buffers checked before the failing one */
+        {
+            struct iovec *iov = msgs[i].msg_hdr.msg_iov;
+            while (j--) update_write_watches( iov[j].iov_base, iov[j].iov_len, 0 );
+        }
+        while (i--)
+        {
+            struct msghdr *hdr = &msgs[i].msg_hdr;
+
+            len = (int)i < ret ? msgs[i].msg_len : 0;
+            for (j = 0; j < hdr->msg_iovlen; j++)
+            {
+                size_t size = min( len, hdr->msg_iov[j].iov_len );
+
+                update_write_watches( hdr->msg_iov[j].iov_base, hdr->msg_iov[j].iov_len, size );
+                len -= size;
+            }
+        }
+    }
+    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    errno = err;
+    return ret;
+}
+#endif
+
+
 /***********************************************************************
  *           virtual_is_valid_code_address
  */
@@ -4109,6 +4504,19 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
         return STATUS_INVALID_PARAMETER;
     }
 
+    if (type & MEM_LARGE_PAGES)
+    {
+        if (!(type & MEM_COMMIT) || !(type & MEM_RESERVE) || is_dos_memory ||
+            (type & (MEM_WRITE_WATCH | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER)) ||
+            ((UINT_PTR)base & large_page_mask) || (size & large_page_mask))
+        {
+            WARN("Invalid large pages allocation %p-%p type %#x.\n", base, (char *)base + size, (int)type);
+            return STATUS_INVALID_PARAMETER;
+        }
+        if (!has_lock_memory_privilege()) return STATUS_PRIVILEGE_NOT_HELD;
+        if (align <= large_page_mask) align = large_page_mask + 1;
+    }
+
     /* Reserve the memory */
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
@@ -4127,7 +4535,17 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
             else status = map_view( &view, base, size, type & (MEM_TOP_DOWN | MEM_REPLACE_PLACEHOLDER), vprot, limit,
                                     align ? align - 1 : granularity_mask );
 
-            if (status == STATUS_SUCCESS) base = view->base;
+            if (status == STATUS_SUCCESS)
+            {
+                base = view->base;
+                if (type & MEM_LARGE_PAGES)
+                {
+                    if ((status = map_large_pages( view, vprot ))) delete_view( view );
+                }
+                else if (hugepage_min_size && size >= hugepage_min_size && !is_dos_memory &&
+                         !(vprot & (VPROT_WRITEWATCH | VPROT_PLACEHOLDER)))
+                    advise_huge_pages( base, size );
+            }
         }
     }
     else if (type & MEM_RESET)
@@ -4173,7 +4591,8 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR zero_bits,
                                          SIZE_T *size_ptr, ULONG type, ULONG protect )
 {
-    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET;
+    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET
+                                   | MEM_LARGE_PAGES;
     ULONG_PTR limit;
 
     TRACE("%p %p %08lx %x %08x\n", process, *ret, *size_ptr, (int)type, (int)protect );
@@ -4234,7 +4653,8 @@ NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *s
                                            ULONG count )
 {
     static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH
-                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER;
+                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER
+                                   | MEM_LARGE_PAGES;
     ULONG_PTR limit = 0;
     ULONG_PTR align = 0;
 
@@ -4388,6 +4808,8 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
 
         if (size && (char *)view->base + view->size - base < size) status = STATUS_UNABLE_TO_FREE_VM;
         else if (!size && base != view->base) status = STATUS_FREE_VM_NOT_AT_BASE;
+        else if ((view->protect & SEC_LARGE_PAGES) && (((UINT_PTR)base | size) & large_page_mask))
+            status = STATUS_INVALID_PARAMETER;
         else if (type == (MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER) && !size) status = STATUS_INVALID_PARAMETER_3;
         else if (type == (MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER) && !((view->protect & VPROT_FROMPLACEHOLDER)
                  || (view->protect & VPROT_PLACEHOLDER && size != view->size)))
@@ -4931,6 +5353,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
 
             p->VirtualAttributes.Valid = !(vprot & VPROT_GUARD) && (vprot & 0x0f) && (pagemap >> 63);
             p->VirtualAttributes.Shared = !is_view_valloc( view ) && ((pagemap >> 61) & 1);
+            p->VirtualAttributes.LargePage = p->VirtualAttributes.Valid && (view->protect & SEC_LARGE_PAGES);
             if (p->VirtualAttributes.Shared && p->VirtualAttributes.Valid)
                 p->VirtualAttributes.ShareCount = 1; /* FIXME */
             if (p->VirtualAttributes.Valid)
@@ -844,6 +844,105 @@ static void test_inter_process_child( HWND hwnd )
     PostMessageA( hwnd, WM_USER, 0, 0 );
 }
 
+static LRESULT WINAPI test_window_shared_proc( HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam )
+{
+    if (msg == WM_USER)
+    {
+        HWND child = GetWindow( hwnd, GW_CHILD );
+
+        SetWindowPos( hwnd, 0, 50, 60, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_SHOWWINDOW );
+        SetWindowLongPtrW( child, GWLP_USERDATA, 0xfeedf00d );
+        SetWindowLongPtrW( child, GWLP_ID, 456 );
+        return 0;
+    }
+    return DefWindowProcW( hwnd, msg, wparam, lparam );
+}
+
+static void test_window_shared( const char *argv0 )
+{
+    WNDCLASSW cls = { 0 };
+    char path[MAX_PATH];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA startup;
+    HWND hwnd, child;
+    MSG msg;
+    BOOL ret;
+
+    cls.lpfnWndProc = test_window_shared_proc;
+    cls.lpszClassName = L"TestSharedClass";
+    RegisterClassW( &cls );
+
+    hwnd = CreateWindowExW( 0, L"TestSharedClass", NULL, WS_POPUP, 100, 100, 200, 150, 0, 0, 0, NULL );
+    child = CreateWindowExW( 0, L"static", NULL, WS_CHILD | WS_VISIBLE, 10, 20, 50, 40, hwnd,
+                             (HMENU)123, 0, NULL );
+    SetWindowLongPtrW( child, GWLP_USERDATA, 0xdeadbeef );
+
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    sprintf( path, "%s win32u winshared %Ix %lx %lx", argv0, (INT_PTR)hwnd,
+             GetWindowLongW( hwnd, GWL_STYLE ), GetWindowLongW( child, GWL_STYLE ) );
+    ret = CreateProcessA( NULL, path, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &pi );
+    ok( ret, "CreateProcess '%s' failed err %lu.\n", path, GetLastError() );
+
+    do
+    {
+        GetMessageW( &msg, NULL, 0, 0 );
+        TranslateMessage( &msg );
+        DispatchMessageW( &msg );
+    } while (msg.message != WM_USER + 1);
+
+    wait_child_process( pi.hProcess );
+
+    CloseHandle( pi.hThread );
+    CloseHandle( pi.hProcess );
+
+    DestroyWindow( hwnd );
+    UnregisterClassW( L"TestSharedClass", NULL );
+}
+
+/* query the windows of another process, which may not need a server call */
+static void test_window_shared_child( HWND hwnd, DWORD style, DWORD child_style )
+{
+    HWND child = GetWindow( hwnd, GW_CHILD );
+    RECT rect;
+
+    ok( child != NULL, "no child window\n" );
+
+    ok( GetWindowLongW( GetDesktopWindow(), GWL_STYLE ) == (WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN),
+        "got desktop style %#lx\n", GetWindowLongW( GetDesktopWindow(), GWL_STYLE ) );
+    ok( GetWindowLongW( hwnd, GWL_STYLE ) == style, "got style %#lx\n", GetWindowLongW( hwnd, GWL_STYLE ) );
+    ok( GetWindowLongW( child, GWL_STYLE ) == child_style, "got child style %#lx\n",
+        GetWindowLongW( child, GWL_STYLE ) );
+    ok( GetWindowLongPtrW( child, GWLP_ID ) == 123, "got id %Id\n", GetWindowLongPtrW( child, GWLP_ID ) );
+    ok( GetWindowLongPtrW( child, GWLP_USERDATA ) == 0xdeadbeef, "got user data %#Ix\n",
+        GetWindowLongPtrW( child, GWLP_USERDATA ) );
+    ok( !IsWindowVisible( child ), "child is visible\n" );
+
+    GetWindowRect( hwnd, &rect );
+    ok( EqualRect( &rect, &(RECT){100, 100, 300, 250} ), "got window rect %s\n", wine_dbgstr_rect( &rect ) );
+    GetWindowRect( child, &rect );
+    ok( EqualRect( &rect, &(RECT){110, 120, 160, 160} ), "got child rect %s\n", wine_dbgstr_rect( &rect ) );
+    GetClientRect( child, &rect );
+    ok( EqualRect( &rect, &(RECT){0, 0, 50, 40} ), "got child client rect %s\n", wine_dbgstr_rect( &rect ) );
+
+    /* changes made by the owner process are seen right away */
+    SendMessageW( hwnd, WM_USER, 0, 0 );
+
+    ok( GetWindowLongW( hwnd, GWL_STYLE ) == (style | WS_VISIBLE), "got style %#lx\n",
+        GetWindowLongW( hwnd, GWL_STYLE ) );
+    ok( GetWindowLongPtrW( child, GWLP_ID ) == 456, "got id %Id\n", GetWindowLongPtrW( child, GWLP_ID ) );
+    ok( GetWindowLongPtrW( child, GWLP_USERDATA ) == 0xfeedf00d, "got user data %#Ix\n",
+        GetWindowLongPtrW( child, GWLP_USERDATA ) );
+    ok( IsWindowVisible( child ), "child is not visible\n" );
+
+    GetWindowRect( hwnd, &rect );
+    ok( EqualRect( &rect, &(RECT){50, 60, 250, 210} ), "got window rect %s\n", wine_dbgstr_rect( &rect ) );
+    GetWindowRect( child, &rect );
+    ok( EqualRect( &rect, &(RECT){60, 80, 110, 120} ), "got child rect %s\n", wine_dbgstr_rect( &rect ) );
+
+    PostMessageW( hwnd, WM_USER + 1, 0, 0 );
+}
+
 static DWORD CALLBACK test_NtUserGetPointerInfoList_thread( void *arg )
 {
     POINTER_INFO pointer_info[4] = {0};
@@ -1137,6 +1236,13 @@ START_TEST(win32u)
         return;
     }
 
+    if (argc > 5 && !strcmp( argv[2], "winshared" ))
+    {
+        test_window_shared_child( LongToHandle( strtol( argv[3], NULL, 16 )), strtoul( argv[4], NULL, 16 ),
+                                  strtoul( argv[5], NULL, 16 ));
+        return;
+    }
+
     if (argc > 3 && !strcmp( argv[2], "NtUserEnableMouseInPointer" ))
     {
         winetest_push_context( "enable %s", argv[3] );
@@ -1156,6 +1262,7 @@ START_TEST(win32u)
     test_message_filter();
     test_timer();
     test_inter_process_messages( argv[0] );
+    test_window_shared( argv[0] );
 
     test_NtUserCloseWindowStation();
     test_NtUserDisplayConfigGetDeviceInfo();
@@ -77,6 +77,42 @@ HANDLE alloc_user_handle( struct user_object *ptr, unsigned int type )
     return handle;
 }
 
+/***********************************************************************
+ *           get_shared_window_info
+ *
+ * Read the information the server publishes for a window, without a server call.
+ * Returns FALSE if it isn't available, in which case the server must be asked.
+ */
+static BOOL get_shared_window_info( HWND hwnd, struct window_shared_memory *info )
+{
+    volatile struct window_shared_memory *shared;
+    WORD index = USER_HANDLE_TO_INDEX( hwnd );
+    UINT handle = HandleToUlong( hwnd );
+
+    if (index >= NB_USER_HANDLES || !(shared = get_window_shared_memory())) return FALSE;
+    shared += index;
+
+    SHARED_READ_BEGIN( &shared->seq )
+    {
+        info->handle      = shared->handle;
+        info->parent      = shared->parent;
+        info->owner       = shared->owner;
+        info->style       = shared->style;
+        info->ex_style    = shared->ex_style;
+        info->dpi         = shared->dpi;
+        info->instance    = shared->instance;
+        info->id          = shared->id;
+        info->user_data   = shared->user_data;
+        info->window_rect = shared->window_rect;
+        info->client_rect = shared->client_rect;
+    }
+    SHARED_READ_END( &shared->seq );
+
+    if (!info->handle) return FALSE;
+    if (!HIWORD(handle) || HIWORD(handle) == 0xffff) return LOWORD(info->handle) == LOWORD(handle);
+    return info->handle == handle;
+}
+
 /***********************************************************************
  *           get_user_handle_ptr
  */
@@ -771,11 +807,23 @@ BOOL is_child( HWND parent, HWND child )
 /* see IsWindowVisible */
 BOOL is_window_visible( HWND hwnd )
 {
+    struct window_shared_memory info;
     HWND *list;
     BOOL retval = TRUE;
     int i;
 
     if (!(get_window_long( hwnd, GWL_STYLE ) & WS_VISIBLE)) return FALSE;
+    if (get_shared_window_info( hwnd, &info ))
+    {
+        /* walk up the parents, the top window must be the desktop and isn't checked */
+        for (i = 0; i < 64 && info.parent; i++)
+        {
+            HWND parent = UlongToHandle( info.parent );
+            if (!get_shared_window_info( parent, &info )) break;
+            if (!info.parent) return parent == get_desktop_window();
+            if (!(info.style & WS_VISIBLE)) return FALSE;
+        }
+    }
     if (!(list = list_window_parents( hwnd ))) return TRUE;
     if (list[0])
     {
@@ -1045,11 +1093,24 @@ static LONG_PTR get_window_long_size( HWND hwnd, INT offset, UINT size, BOOL ans
 
     if (win == WND_OTHER_PROCESS)
     {
+        struct window_shared_memory info;
+
         if (offset == GWLP_WNDPROC)
         {
             RtlSetLastWin32Error( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if (offset < 0 && get_shared_window_info( hwnd, &info ))
+        {
+            switch(offset)
+            {
+            case GWL_STYLE:      return info.style;
+            case GWL_EXSTYLE:    return info.ex_style;
+            case GWLP_ID:        return info.id;
+            case GWLP_HINSTANCE: return (ULONG_PTR)wine_server_get_ptr( info.instance );
+            case GWLP_USERDATA:  return info.user_data;
+            }
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -1576,6 +1637,7 @@ static void mirror_rect( const RECT *window_rect, RECT *rect )
 BOOL get_window_rects( HWND hwnd, enum coords_relative relative, RECT *window_rect,
                        RECT *client_rect, UINT dpi )
 {
+    struct window_shared_memory info;
     WND *win = get_win_ptr( hwnd );
     BOOL ret = TRUE;
 
@@ -1678,6 +1740,50 @@ BOOL get_window_rects( HWND hwnd, enum coords_relative relative, RECT *window_re
     }
 
 other_process:
+    /* rectangles don't need DPI mapping if the DPIs are the same, including both per-monitor */
+    if (relative != COORDS_PARENT && get_shared_window_info( hwnd, &info ) && info.dpi == dpi)
+    {
+        RECT window, client;
+
+        window.left   = info.window_rect.left;
+        window.top    = info.window_rect.top;
+        window.right  = info.window_rect.right;
+        window.bottom = info.window_rect.bottom;
+        client.left   = info.client_rect.left;
+        client.top    = info.client_rect.top;
+        client.right  = info.client_rect.right;
+        client.bottom = info.client_rect.bottom;
+
+        switch (relative)
+        {
+        case COORDS_CLIENT:
+            OffsetRect( &window, -client.left, -client.top );
+            OffsetRect( &client, -client.left, -client.top );
+            if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &client, &window );
+            break;
+        case COORDS_WINDOW:
+            OffsetRect( &client, -window.left, -window.top );
+            OffsetRect( &window, -window.left, -window.top );
+            if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &window, &client );
+            break;
+        case COORDS_SCREEN:
+        {
+            /* only top-level windows, their rectangles are already in screen coordinates */
+            struct window_shared_memory parent;
+            if (!info.parent || !get_shared_window_info( UlongToHandle( info.parent ), &parent ) ||
+                parent.parent)
+                goto server_call;
+            break;
+        }
+        default:
+            break;
+        }
+        if (window_rect) *window_rect = window;
+        if (client_rect) *client_rect = client;
+        return TRUE;
+    }
+
+server_call:
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -764,6 +764,37 @@ volatile struct input_shared_memory *get_foreground_shared_memory( void )
     return get_thread_input_shared_memory( tid, &thread_info->foreground_shared_memory );
 }
 
+/* shared information of all windows, indexed by user handle */
+volatile struct window_shared_memory *get_window_shared_memory( void )
+{
+    static const WCHAR window_mappingW[] =
+    {
+        '\\','K','e','r','n','e','l','O','b','j','e','c','t','s','\\',
+        '_','_','w','i','n','e','_','t','h','r','e','a','d','_','m','a','p','p','i','n','g','s','\\',
+        'w','i','n','d','o','w','s',0
+    };
+    static struct window_shared_memory *window_shared;
+    static LONG failed;
+    struct window_shared_memory *ret;
+
+    __WINE_ATOMIC_LOAD_RELAXED( &window_shared, &ret );
+    if (ret || failed) return ret;
+
+    map_shared_memory_section( window_mappingW, ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1) *
+                               sizeof(struct window_shared_memory), NULL, (void **)&ret );
+    if (!ret)
+    {
+        failed = TRUE;
+        return NULL;
+    }
+    if (InterlockedCompareExchangePointer( (void **)&window_shared, ret, NULL ))
+    {
+        NtUnmapViewOfSection( GetCurrentProcess(), ret );
+        ret = window_shared;
+    }
+    return ret;
+}
+
 /***********************************************************************
  *           winstation_init
  *
@@ -90,6 +90,145 @@ static inline float to_sRGB_component(float f)
     return 1.055f * powf(f, 1.0f/2.4f) - 0.055f;
 }
 
+static inline BYTE to_sRGB_byte_slow(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+/* smallest input of to_sRGB_byte_slow() giving each output value */
+static float srgb_thresholds[256];
+/* 255 / alpha in 16.16 fixed point, truncating like the integer division */
+static UINT unpremultiply_factors[256];
+static INIT_ONCE init_tables_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI init_tables(INIT_ONCE *once, void *param, void **context)
+{
+    union { float f; UINT u; } lo, hi, mid;
+    UINT i;
+
+    for (i = 1; i < 256; i++)
+    {
+        lo.f = 0.0f;
+        hi.f = 1.0f;
+        if (to_sRGB_byte_slow(hi.f) < i)
+        {
+            srgb_thresholds[i] = 2.0f;
+            continue;
+        }
+        /* positive floats are ordered like their bit patterns */
+        while (lo.u < hi.u)
+        {
+            mid.u = lo.u + (hi.u - lo.u) / 2;
+            if (to_sRGB_byte_slow(mid.f) >= i) hi.u = mid.u;
+            else lo.u = mid.u + 1;
+        }
+        srgb_thresholds[i] = lo.f;
+    }
+
+    for (i = 1; i < 256; i++)
+        unpremultiply_factors[i] = (255 * 65536 + i - 1) / i;
+
+    return TRUE;
+}
+
+static void init_conversion_tables(void)
+{
+    InitOnceExecuteOnce(&init_tables_once, init_tables, NULL, NULL);
+}
+
+/* same result as to_sRGB_byte_slow(), init_conversion_tables() must have been called */
+static inline BYTE to_sRGB_byte(float f)
+{
+    UINT lo = 1, hi = 255, ret = 0, mid;
+
+    if (!(f >= 0.0f && f <= 1.0f)) return to_sRGB_byte_slow(f);
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        if (srgb_thresholds[mid] <= f)
+        {
+            ret = mid;
+            lo = mid + 1;
+        }
+        else hi = mid - 1;
+    }
+    return ret;
+}
+
+/* (c * alpha + 127) / 255 without a division */
+static inline DWORD premultiply_component(DWORD c, DWORD alpha)
+{
+    DWORD t = c * alpha + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+/* premultiply a row of 32bpp pixels, optionally swapping red and blue */
+static void premultiply_row(BYTE *row, UINT width, BOOL swap_rb)
+{
+    DWORD *pixel = (DWORD *)row, p, alpha, c0, c2;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        p = pixel[x];
+        alpha = p >> 24;
+        c0 = p & 0xff;
+        c2 = (p >> 16) & 0xff;
+        if (swap_rb)
+        {
+            c0 = c2;
+            c2 = p & 0xff;
+        }
+        if (alpha == 255)
+            pixel[x] = (p & 0xff00ff00) | (c2 << 16) | c0;
+        else
+            pixel[x] = (alpha << 24) | (premultiply_component(c2, alpha) << 16) |
+                       (premultiply_component((p >> 8) & 0xff, alpha) << 8) | premultiply_component(c0, alpha);
+    }
+}
+
+/* undo alpha premultiplication of a row of 32bpp pixels, init_conversion_tables() must have been called */
+static void unpremultiply_row(BYTE *row, UINT width)
+{
+    DWORD *pixel = (DWORD *)row, p, alpha, factor;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        p = pixel[x];
+        alpha = p >> 24;
+        if (alpha == 0 || alpha == 255) continue;
+        factor = unpremultiply_factors[alpha];
+        pixel[x] = (p & 0xff000000) | ((((p >> 16) & 0xff) * factor >> 16 & 0xff) << 16) |
+                   ((((p >> 8) & 0xff) * factor >> 16 & 0xff) << 8) | ((p & 0xff) * factor >> 16 & 0xff);
+    }
+}
+
+static BOOL format_has_alpha(enum pixelformat format)
+{
+    switch (format)
+    {
+    case format_8bppGray:
+    case format_16bppGray:
+    case format_16bppBGR555:
+    case format_16bppBGR565:
+    case format_24bppBGR:
+    case format_24bppRGB:
+    case format_32bppGrayFloat:
+    case format_32bppBGR:
+    case format_32bppRGB:
+    case format_48bppRGB:
+    case format_32bppCMYK:
+    case format_BlackWhite:
+    case format_2bppGray:
+    case format_4bppGray:
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
 #if 0 /* FIXME: enable once needed */
 static inline float from_sRGB_component(float f)
 {
@@ -738,22 +877,14 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
+            init_conversion_tables();
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
     case format_48bppRGB:
@@ -902,22 +1033,14 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
+            INT y;
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
+            init_conversion_tables();
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
 
@@ -972,23 +1095,37 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
         if (prc)
             return IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
         return S_OK;
+    case format_32bppPRGBA:
+        if (prc)
+        {
+            hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (SUCCEEDED(hr))
+                reverse_bgr8(4, pbBuffer, prc->Width, prc->Height, cbStride);
+            return hr;
+        }
+        return S_OK;
+    case format_32bppBGRA:
+    case format_32bppRGBA:
+        if (prc)
+        {
+            INT y;
+
+            /* convert in a single pass, swapping components if needed */
+            hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (FAILED(hr)) return hr;
+
+            for (y=0; y<prc->Height; y++)
+                premultiply_row(pbBuffer + cbStride * y, prc->Width, source_format == format_32bppRGBA);
+        }
+        return S_OK;
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
-        if (SUCCEEDED(hr) && prc)
+        if (SUCCEEDED(hr) && prc && format_has_alpha(source_format))
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = (pbBuffer[cbStride*y+4*x] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+1] = (pbBuffer[cbStride*y+4*x+1] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+2] = (pbBuffer[cbStride*y+4*x+2] * alpha + 127) / 255;
-                    }
-                }
+                premultiply_row(pbBuffer + cbStride * y, prc->Width, FALSE);
         }
         return hr;
     }
@@ -1005,23 +1142,37 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
         if (prc)
             return IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
         return S_OK;
+    case format_32bppPBGRA:
+        if (prc)
+        {
+            hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (SUCCEEDED(hr))
+                reverse_bgr8(4, pbBuffer, prc->Width, prc->Height, cbStride);
+            return hr;
+        }
+        return S_OK;
+    case format_32bppRGBA:
+    case format_32bppBGRA:
+        if (prc)
+        {
+            INT y;
+
+            /* convert in a single pass, swapping components if needed */
+            hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (FAILED(hr)) return hr;
+
+            for (y=0; y<prc->Height; y++)
+                premultiply_row(pbBuffer + cbStride * y, prc->Width, source_format == format_32bppBGRA);
+        }
+        return S_OK;
     default:
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
-        if (SUCCEEDED(hr) && prc)
+        if (SUCCEEDED(hr) && prc && format_has_alpha(source_format))
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = (pbBuffer[cbStride*y+4*x] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+1] = (pbBuffer[cbStride*y+4*x+1] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+2] = (pbBuffer[cbStride*y+4*x+2] * alpha + 127) / 255;
-                    }
-                }
+                premultiply_row(pbBuffer + cbStride * y, prc->Width, FALSE);
         }
         return hr;
     }
@@ -1131,6 +1282,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_conversion_tables();
                 for (y = 0; y < prc->Height; y++)
                 {
                     float *gray_float = (float *)src;
@@ -1138,7 +1290,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = to_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1351,13 +1503,14 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_conversion_tables();
                 for (y=0; y < prc->Height; y++)
                 {
                     float *srcpixel = (float*)src;
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = to_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1385,6 +1538,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
         INT x, y;
         BYTE *src = srcdata, *dst = pbBuffer;
 
+        init_conversion_tables();
         for (y = 0; y < prc->Height; y++)
         {
             BYTE *bgr = src;
@@ -1393,8 +1547,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
             {
                 float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
 
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
+                dst[x] = to_sRGB_byte(gray);
                 bgr += 3;
             }
             src += srcstride;
@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -31,6 +32,14 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+struct filter_weights
+{
+    UINT taps;          /* maximum number of source pixels contributing to a destination pixel */
+    UINT *start;        /* first contributing source pixel, for each destination pixel */
+    UINT *count;        /* number of contributing source pixels, for each destination pixel */
+    float *weights;     /* taps weights for each destination pixel */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -42,6 +51,13 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    UINT channels; /* number of 8-bit channels for filtering modes, 0 for nearest neighbor */
+    BOOL straight_alpha; /* alpha is not premultiplied, filter colors weighted by alpha */
+    struct filter_weights x_weights, y_weights;
+    BYTE *src_row;
+    float *filtered_rows; /* cache of horizontally filtered source rows */
+    INT *filtered_rows_y; /* source row held in each cache slot, -1 if none */
+    float *dst_row;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -55,6 +71,29 @@ static inline BitmapScaler *impl_from_IMILBitmapScaler(IMILBitmapScaler *iface)
     return CONTAINING_RECORD(iface, BitmapScaler, IMILBitmapScaler_iface);
 }
 
+static void free_filter_weights(struct filter_weights *weights)
+{
+    HeapFree(GetProcessHeap(), 0, weights->start);
+    HeapFree(GetProcessHeap(), 0, weights->count);
+    HeapFree(GetProcessHeap(), 0, weights->weights);
+    memset(weights, 0, sizeof(*weights));
+}
+
+static void free_filter(BitmapScaler *This)
+{
+    free_filter_weights(&This->x_weights);
+    free_filter_weights(&This->y_weights);
+    HeapFree(GetProcessHeap(), 0, This->src_row);
+    HeapFree(GetProcessHeap(), 0, This->filtered_rows);
+    HeapFree(GetProcessHeap(), 0, This->filtered_rows_y);
+    HeapFree(GetProcessHeap(), 0, This->dst_row);
+    This->src_row = NULL;
+    This->filtered_rows = NULL;
+    This->filtered_rows_y = NULL;
+    This->dst_row = NULL;
+    This->channels = 0;
+}
+
 static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
     void **ppv)
 {
@@ -106,6 +145,7 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter(This);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -203,6 +243,220 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static float linear_kernel(float x)
+{
+    x = fabsf(x);
+    return x < 1.0f ? 1.0f - x : 0.0f;
+}
+
+/* Catmull-Rom spline */
+static float cubic_kernel(float x)
+{
+    x = fabsf(x);
+    if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+    if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+    return 0.0f;
+}
+
+/* precompute the weights of the source pixels contributing to each destination pixel */
+static HRESULT init_filter_weights(struct filter_weights *filter, UINT src_size, UINT dst_size,
+    WICBitmapInterpolationMode mode)
+{
+    float scale = (float)src_size / dst_size, filter_scale = 1.0f, radius, center, sum, *weights;
+    float (*kernel)(float);
+    INT j, lo, hi, first, last;
+    UINT i, k, taps;
+
+    if (mode == WICBitmapInterpolationModeFant && scale > 1.0f)
+    {
+        /* box filter, the weights are the source areas covered by each destination pixel */
+        kernel = NULL;
+        radius = scale / 2.0f + 1.0f;
+    }
+    else if (mode == WICBitmapInterpolationModeCubic || mode == WICBitmapInterpolationModeHighQualityCubic)
+    {
+        kernel = cubic_kernel;
+        radius = 2.0f;
+    }
+    else
+    {
+        kernel = linear_kernel;
+        radius = 1.0f;
+    }
+
+    /* widen the filter when downscaling to take all the source pixels into account */
+    if (mode == WICBitmapInterpolationModeHighQualityCubic && scale > 1.0f)
+        filter_scale = scale;
+    if (kernel) radius *= filter_scale;
+
+    taps = min((UINT)ceilf(2.0f * radius) + 1, src_size);
+
+    filter->taps = taps;
+    filter->start = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(*filter->start));
+    filter->count = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(*filter->count));
+    filter->weights = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, dst_size * taps * sizeof(*filter->weights));
+    if (!filter->start || !filter->count || !filter->weights)
+    {
+        free_filter_weights(filter);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        weights = filter->weights + i * taps;
+
+        if (!kernel)
+        {
+            float a = i * scale, b = a + scale;
+
+            first = min((INT)floorf(a), (INT)src_size - 1);
+            last = min((INT)ceilf(b), (INT)src_size) - 1;
+            if (last - first >= (INT)taps) last = first + taps - 1;
+            for (j = first; j <= last; j++)
+                weights[j - first] = max(min(b, j + 1.0f) - max(a, (float)j), 0.0f);
+        }
+        else
+        {
+            center = (i + 0.5f) * scale - 0.5f;
+            lo = (INT)floorf(center - radius) + 1;
+            hi = (INT)ceilf(center + radius) - 1;
+            first = min(max(lo, 0), (INT)src_size - 1);
+            last = max(min(hi, (INT)src_size - 1), first);
+            if (last - first >= (INT)taps) last = first + taps - 1;
+            /* pixels outside of the source repeat the edges */
+            for (j = lo; j <= hi; j++)
+                weights[min(max(j, first), last) - first] += kernel((j - center) / filter_scale);
+        }
+
+        for (k = 0, sum = 0.0f; k <= last - first; k++) sum += weights[k];
+        if (sum != 0.0f)
+            for (k = 0; k <= last - first; k++) weights[k] /= sum;
+        else
+            weights[0] = 1.0f;
+
+        filter->start[i] = first;
+        filter->count[i] = last - first + 1;
+    }
+
+    return S_OK;
+}
+
+/* apply the horizontal filter to a source row, premultiplying straight alpha colors */
+static void filter_row(const struct filter_weights *filter, UINT channels, BOOL straight_alpha,
+    UINT dst_width, const BYTE *src, float *dst)
+{
+    const float *weights;
+    const BYTE *pixel;
+    float sum[4], alpha;
+    UINT x, i, c;
+
+    for (x = 0; x < dst_width; x++)
+    {
+        pixel = src + filter->start[x] * channels;
+        weights = filter->weights + x * filter->taps;
+        sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+
+        if (straight_alpha)
+        {
+            for (i = 0; i < filter->count[x]; i++, pixel += channels)
+            {
+                alpha = pixel[3] * weights[i];
+                sum[0] += pixel[0] * alpha;
+                sum[1] += pixel[1] * alpha;
+                sum[2] += pixel[2] * alpha;
+                sum[3] += alpha;
+            }
+        }
+        else
+        {
+            for (i = 0; i < filter->count[x]; i++, pixel += channels)
+                for (c = 0; c < channels; c++)
+                    sum[c] += pixel[c] * weights[i];
+        }
+
+        for (c = 0; c < channels; c++)
+            *dst++ = sum[c];
+    }
+}
+
+/* get a horizontally filtered source row, reading it from the source if it isn't cached */
+static HRESULT get_filtered_row(BitmapScaler *This, UINT src_y, const float **row)
+{
+    UINT slot = src_y % This->y_weights.taps, stride = This->src_width * This->channels;
+    float *filtered = This->filtered_rows + slot * This->width * This->channels;
+    WICRect rect;
+    HRESULT hr;
+
+    if (This->filtered_rows_y[slot] != src_y)
+    {
+        rect.X = 0;
+        rect.Y = src_y;
+        rect.Width = This->src_width;
+        rect.Height = 1;
+        hr = IWICBitmapSource_CopyPixels(This->source, &rect, stride, stride, This->src_row);
+        if (FAILED(hr)) return hr;
+
+        filter_row(&This->x_weights, This->channels, This->straight_alpha, This->width,
+            This->src_row, filtered);
+        This->filtered_rows_y[slot] = src_y;
+    }
+
+    *row = filtered;
+    return S_OK;
+}
+
+/* Scale each destination row by combining horizontally filtered source rows.
+ * Filtered rows are cached between calls, so that reading the image line by
+ * line only reads each source line once. */
+static HRESULT Filter_CopyPixels(BitmapScaler *This, const WICRect *dest_rect, UINT stride, BYTE *buffer)
+{
+    UINT x, y, i, start, count, offset = dest_rect->X * This->channels, size = dest_rect->Width * This->channels;
+    const float *weights, *row;
+    float *dst = This->dst_row, value, alpha;
+    HRESULT hr;
+
+    for (y = 0; y < dest_rect->Height; y++, buffer += stride)
+    {
+        start = This->y_weights.start[dest_rect->Y + y];
+        count = This->y_weights.count[dest_rect->Y + y];
+        weights = This->y_weights.weights + (dest_rect->Y + y) * This->y_weights.taps;
+
+        for (x = 0; x < size; x++) dst[x] = 0.0f;
+
+        for (i = 0; i < count; i++)
+        {
+            if (FAILED(hr = get_filtered_row(This, start + i, &row))) return hr;
+            row += offset;
+            for (x = 0; x < size; x++) dst[x] += row[x] * weights[i];
+        }
+
+        /* colors were weighted by alpha, divide by the filtered alpha to get them back */
+        if (This->straight_alpha)
+        {
+            for (x = 0; x < size; x += 4)
+            {
+                alpha = dst[x + 3];
+                if (alpha > 0.0f)
+                {
+                    dst[x] /= alpha;
+                    dst[x + 1] /= alpha;
+                    dst[x + 2] /= alpha;
+                }
+                else
+                    dst[x] = dst[x + 1] = dst[x + 2] = 0.0f;
+            }
+        }
+
+        for (x = 0; x < size; x++)
+        {
+            value = dst[x] + 0.5f;
+            buffer[x] = value <= 0.0f ? 0 : value >= 255.0f ? 255 : (BYTE)value;
+        }
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -257,6 +511,12 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->channels)
+    {
+        hr = Filter_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -312,6 +572,57 @@ end:
     return hr;
 }
 
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat8bppAlpha,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGB,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
+static HRESULT init_filter(BitmapScaler *This, WICBitmapInterpolationMode mode)
+{
+    UINT i, channels = This->bpp / 8;
+    HRESULT hr;
+
+    if (FAILED(hr = init_filter_weights(&This->x_weights, This->src_width, This->width, mode)))
+        return hr;
+    if (FAILED(hr = init_filter_weights(&This->y_weights, This->src_height, This->height, mode)))
+    {
+        free_filter_weights(&This->x_weights);
+        return hr;
+    }
+
+    This->src_row = HeapAlloc(GetProcessHeap(), 0, (SIZE_T)This->src_width * channels);
+    This->filtered_rows = HeapAlloc(GetProcessHeap(), 0,
+        (SIZE_T)This->y_weights.taps * This->width * channels * sizeof(float));
+    This->filtered_rows_y = HeapAlloc(GetProcessHeap(), 0, This->y_weights.taps * sizeof(INT));
+    This->dst_row = HeapAlloc(GetProcessHeap(), 0, (SIZE_T)This->width * channels * sizeof(float));
+    if (!This->src_row || !This->filtered_rows || !This->filtered_rows_y || !This->dst_row)
+    {
+        free_filter(This);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < This->y_weights.taps; i++) This->filtered_rows_y[i] = -1;
+    This->channels = channels;
+    return S_OK;
+}
+
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
     WICBitmapInterpolationMode mode)
@@ -351,6 +662,39 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            if ((This->bpp % 8) == 0)
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+            }
+            else
+            {
+                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
+                    pISource, &This->source);
+                src_pixelformat = GUID_WICPixelFormat32bppBGRA;
+                This->bpp = 32;
+            }
+
+            if (SUCCEEDED(hr) && is_filterable_format(&src_pixelformat))
+            {
+                This->straight_alpha = IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppBGRA)
+                        || IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppRGBA);
+                if (FAILED(hr = init_filter(This, mode)))
+                {
+                    IWICBitmapSource_Release(This->source);
+                    This->source = NULL;
+                }
+                break;
+            }
+
+            FIXME("unsupported pixel format %s for mode %i\n", debugstr_guid(&src_pixelformat), mode);
+            This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
+            This->fn_copy_scanline = NearestNeighbor_CopyScanline;
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -527,6 +871,14 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->channels = 0;
+    This->straight_alpha = FALSE;
+    memset(&This->x_weights, 0, sizeof(This->x_weights));
+    memset(&This->y_weights, 0, sizeof(This->y_weights));
+    This->src_row = NULL;
+    This->filtered_rows = NULL;
+    This->filtered_rows_y = NULL;
+    This->dst_row = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -19,6 +19,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <math.h>
 
@@ -1315,6 +1316,166 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const BYTE data[] =
+    {
+        0,10,20, 100,110,120, 200,210,220, 50,60,70,
+        40,50,60, 120,130,140, 0,10,20, 250,250,250,
+    };
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeFant,
+    };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE buf[6], expect;
+    HRESULT hr;
+    UINT i, j;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 2, &GUID_WICPixelFormat24bppBGR,
+        12, sizeof(data), (BYTE *)data, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1, modes[i]);
+        ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+        /* halving the size averages each 2x2 block */
+        memset(buf, 0xcc, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 6, sizeof(buf), buf);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        for (j = 0; j < sizeof(buf); j++)
+        {
+            UINT x = j / 3, c = j % 3;
+            expect = (data[6 * x + c] + data[6 * x + 3 + c] + data[12 + 6 * x + c] + data[12 + 6 * x + 3 + c] + 2) / 4;
+            ok(abs(buf[j] - expect) <= 1, "mode %u: got %u at %u, expected %u.\n", modes[i], buf[j], j, expect);
+        }
+
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
+static void test_bitmap_scaler_cubic(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const struct
+    {
+        UINT width, height;
+    }
+    sizes[] = {{2, 2}, {3, 5}, {8, 3}, {13, 11}};
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE data[8 * 6 * 3], buf[13 * 11 * 3];
+    HRESULT hr;
+    UINT i, j, k;
+
+    /* normalized filters keep a flat color, negative lobes must not overshoot */
+    for (i = 0; i < sizeof(data); i += 3)
+    {
+        data[i] = 10;
+        data[i + 1] = 128;
+        data[i + 2] = 250;
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 8, 6, &GUID_WICPixelFormat24bppBGR,
+        24, sizeof(data), data, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap,
+                sizes[j].width, sizes[j].height, modes[i]);
+            ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizes[j].width * 3,
+                sizes[j].width * sizes[j].height * 3, buf);
+            ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+            for (k = 0; k < sizes[j].width * sizes[j].height * 3; k++)
+                ok(abs(buf[k] - data[k % 3]) <= 1, "mode %u, %ux%u: got %u at %u, expected %u.\n",
+                    modes[i], sizes[j].width, sizes[j].height, buf[k], k, data[k % 3]);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
+static void test_bitmap_scaler_alpha(void)
+{
+    static const BYTE data[] =
+    {
+        /* opaque blue, then transparent green */
+        255,0,0,255, 255,0,0,255, 0,255,0,0, 0,255,0,0,
+    };
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const UINT widths[] = {2, 3, 7};
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE buf[7 * 4], *pixel;
+    HRESULT hr;
+    UINT i, j, x;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 1, &GUID_WICPixelFormat32bppBGRA,
+        16, sizeof(data), (BYTE *)data, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(widths); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, widths[j], 1, modes[i]);
+            ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, widths[j] * 4, widths[j] * 4, buf);
+            ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+
+            /* colors of transparent pixels must not bleed into visible ones */
+            for (x = 0; x < widths[j]; x++)
+            {
+                pixel = buf + x * 4;
+                if (pixel[3] < 16) continue;
+                ok(pixel[0] >= 254 && pixel[1] <= 1 && pixel[2] <= 1,
+                    "mode %u, width %u: got %02x%02x%02x%02x at %u.\n", modes[i], widths[j],
+                    pixel[3], pixel[2], pixel[1], pixel[0], x);
+            }
+            ok(buf[3] >= 0xc0, "mode %u, width %u: got alpha %u.\n", modes[i], widths[j], buf[3]);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1485,6 +1646,9 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
+    test_bitmap_scaler_cubic();
+    test_bitmap_scaler_alpha();
 
     IWICImagingFactory_Release(factory);
 
@@ -502,6 +502,8 @@ static const struct bitmap_data testdata_32bppRGBA = {
     &GUID_WICPixelFormat32bppRGBA, 32, bits_32bppRGBA, 32, 2, 96.0, 96.0};
 static const struct bitmap_data testdata_32bppRGB = {
     &GUID_WICPixelFormat32bppRGB, 32, bits_32bppRGBA, 32, 2, 96.0, 96.0};
+static const struct bitmap_data testdata_32bppPBGRA_opaque = {
+    &GUID_WICPixelFormat32bppPBGRA, 32, bits_32bppBGRA, 32, 2, 96.0, 96.0};
 
 static const BYTE bits_32bppPBGRA[] = {
     80,0,0,80, 0,80,0,80, 0,0,80,80, 0,0,0,80, 80,0,0,80, 0,80,0,80, 0,0,80,80, 0,0,0,80,
@@ -2024,6 +2026,8 @@ START_TEST(converter)
     test_conversion(&testdata_32bppBGR, &testdata_32bppBGRA, "BGR -> BGRA", FALSE);
     test_conversion(&testdata_32bppBGRA, &testdata_32bppBGRA, "BGRA -> BGRA", FALSE);
     test_conversion(&testdata_32bppBGRA80, &testdata_32bppPBGRA, "BGRA -> PBGRA", FALSE);
+    test_conversion(&testdata_32bppRGBA, &testdata_32bppPBGRA_opaque, "RGBA -> PBGRA", FALSE);
+    test_conversion(&testdata_24bppRGB, &testdata_32bppPBGRA_opaque, "24bppRGB -> PBGRA", FALSE);
 
     test_conversion(&testdata_32bppRGBA, &testdata_32bppRGB, "RGBA -> RGB", FALSE);
     test_conversion(&testdata_32bppRGB, &testdata_32bppRGBA, "RGB -> RGBA", FALSE);
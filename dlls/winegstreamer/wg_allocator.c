@@ -42,6 +42,7 @@ typedef struct
 
     GstMemory *unix_memory;
     GstMapInfo unix_map_info;
+    GstAllocationParams params;
 
     struct wg_sample *sample;
     gsize written;
@@ -66,6 +67,26 @@ typedef struct
 
 G_DEFINE_TYPE(WgAllocator, wg_allocator, GST_TYPE_ALLOCATOR);
 
+/* Unix memory is only needed when the memory isn't backed by a sample, allocate it lazily */
+static gpointer get_unix_memory_data(WgMemory *memory)
+{
+    if (memory->unix_memory)
+        return memory->unix_map_info.data;
+
+    if (!(memory->unix_memory = gst_allocator_alloc(NULL, memory->parent.maxsize, &memory->params)))
+        return NULL;
+    if (!gst_memory_map(memory->unix_memory, &memory->unix_map_info, GST_MAP_WRITE))
+    {
+        gst_memory_unref(memory->unix_memory);
+        memory->unix_memory = NULL;
+        return NULL;
+    }
+
+    GST_INFO("Allocated unix_memory %p, data %p, for memory %p", memory->unix_memory,
+            memory->unix_map_info.data, memory);
+    return memory->unix_map_info.data;
+}
+
 static gpointer wg_allocator_map(GstMemory *gst_memory, GstMapInfo *info, gsize maxsize)
 {
     WgAllocator *allocator = (WgAllocator *)gst_memory->allocator;
@@ -79,7 +100,7 @@ static gpointer wg_allocator_map(GstMemory *gst_memory, GstMapInfo *info, gsize
     pthread_mutex_lock(&allocator->mutex);
 
     if (!memory->sample)
-        info->data = memory->unix_map_info.data;
+        info->data = get_unix_memory_data(memory);
     else
     {
         InterlockedIncrement(&memory->sample->refcount);
@@ -155,8 +176,10 @@ static GstMemory *wg_allocator_alloc(GstAllocator *gst_allocator, gsize size,
     memory = g_slice_new0(WgMemory);
     gst_memory_init(GST_MEMORY_CAST(memory), 0, GST_ALLOCATOR_CAST(allocator),
             NULL, size, 0, 0, size);
-    memory->unix_memory = gst_allocator_alloc(NULL, size, params);
-    gst_memory_map(memory->unix_memory, &memory->unix_map_info, GST_MAP_WRITE);
+    if (params)
+        memory->params = *params;
+    else
+        gst_allocation_params_init(&memory->params);
 
     pthread_mutex_lock(&allocator->mutex);
 
@@ -170,8 +193,7 @@ static GstMemory *wg_allocator_alloc(GstAllocator *gst_allocator, gsize size,
 
     pthread_mutex_unlock(&allocator->mutex);
 
-    GST_INFO("Allocated memory %p, sample %p, unix_memory %p, data %p", memory,
-            memory->sample, memory->unix_memory, memory->unix_map_info.data);
+    GST_INFO("Allocated memory %p, sample %p", memory, memory->sample);
     return (GstMemory *)memory;
 }
 
@@ -192,8 +214,11 @@ static void wg_allocator_free(GstAllocator *gst_allocator, GstMemory *gst_memory
 
     pthread_mutex_unlock(&allocator->mutex);
 
-    gst_memory_unmap(memory->unix_memory, &memory->unix_map_info);
-    gst_memory_unref(memory->unix_memory);
+    if (memory->unix_memory)
+    {
+        gst_memory_unmap(memory->unix_memory, &memory->unix_map_info);
+        gst_memory_unref(memory->unix_memory);
+    }
     g_slice_free(WgMemory, memory);
 }
 
@@ -238,7 +263,10 @@ static void release_memory_sample(WgAllocator *allocator, WgMemory *memory, bool
     if (memory->written && !discard_data)
     {
         GST_WARNING("Copying %#zx bytes from sample %p, back to memory %p", memory->written, sample, memory);
-        memcpy(memory->unix_map_info.data, memory->sample->data, memory->written);
+        if (!get_unix_memory_data(memory))
+            GST_ERROR("Failed to allocate unix memory for memory %p", memory);
+        else
+            memcpy(memory->unix_map_info.data, memory->sample->data, memory->written);
     }
 
     memory->sample = NULL;
@@ -123,7 +123,19 @@ static gboolean transform_sink_query_cb(GstPad *pad, GstObject *parent, GstQuery
             GstCaps *caps;
 
             gst_query_parse_allocation(query, &caps, &needs_pool);
-            if (stream_type_from_caps(caps) != GST_STREAM_TYPE_VIDEO || !needs_pool)
+            if (stream_type_from_caps(caps) != GST_STREAM_TYPE_VIDEO)
+            {
+                /* Let elements allocating their own buffers, such as audio decoders,
+                 * still write directly to the output sample memory when possible. */
+                gst_query_add_allocation_param(query, transform->allocator, NULL);
+                GST_INFO("Proposing allocator %p for query %p.", transform->allocator, query);
+                return true;
+            }
+
+            /* Video frames not allocated from our pool use the element default
+             * stride, and need to go through copy_video_buffer to get the output
+             * alignment and orientation, so don't let them into the sample. */
+            if (!needs_pool)
                 break;
 
             if (!gst_video_info_from_caps(&info, caps)
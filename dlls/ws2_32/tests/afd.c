@@ -2643,8 +2643,11 @@ static DWORD WINAPI sync_read_file_thread(void *arg)
 
 static void test_read_write(void)
 {
+    static const ULONG large_buffer_size = 65536;
     WSANETWORKEVENTS events;
     IO_STATUS_BLOCK io, io2;
+    char *large_buffer;
+    SIZE_T total;
     SOCKET client, server;
     LARGE_INTEGER offset;
     HANDLE event, thread;
@@ -2759,6 +2762,32 @@ static void test_read_write(void)
     ok(io.Information == 4, "got size %Iu\n", io.Information);
     ok(!memcmp(buffer, "data", 4), "got data %s\n", debugstr_an(buffer, io.Information));
 
+    /* a pending write completes once the peer has read enough data */
+
+    large_buffer = malloc(large_buffer_size);
+    memset(large_buffer, 'a', large_buffer_size);
+    set_blocking(client, FALSE);
+    total = 0;
+    while ((ret = send(client, large_buffer, large_buffer_size, 0)) > 0) total += ret;
+    ok(ret == -1, "got %ld\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+
+    ResetEvent(event);
+    memset(&io2, 0xcc, sizeof(io2));
+    offset.QuadPart = 0;
+    ret = NtWriteFile((HANDLE)client, event, NULL, NULL, &io2, large_buffer, large_buffer_size, &offset, NULL);
+    ok(ret == STATUS_PENDING, "got status %#lx\n", ret);
+
+    total += large_buffer_size;
+    while (total && (ret = recv(server, large_buffer, large_buffer_size, 0)) > 0) total -= ret;
+    ok(!total, "%Iu bytes left\n", total);
+
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "wait timed out\n");
+    ok(!io2.Status, "got status %#lx\n", io2.Status);
+    ok(io2.Information == large_buffer_size, "got size %Iu\n", io2.Information);
+    free(large_buffer);
+
     closesocket(server);
     closesocket(client);
 
@@ -8275,6 +8275,212 @@ static void test_WSAPoll(void)
     closesocket(server);
 }
 
+/* zero-timeout select() and WSAPoll() must report the same state as later calls see */
+static void test_poll_zero_timeout(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    const struct timeval zero = {0};
+    struct sockaddr_in address, peer;
+    SOCKET listener, client[2], server;
+    fd_set readfds, writefds;
+    WSAPOLLFD fds[1];
+    char buffer[4];
+    int ret, len, i, j;
+
+    listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ret = bind(listener, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = listen(listener, 2);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(address);
+    ret = getsockname(listener, (struct sockaddr *)&address, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    FD_ZERO(&readfds);
+    FD_SET(listener, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(!ret, "got %d\n", ret);
+
+    for (i = 0; i < ARRAY_SIZE(client); ++i)
+    {
+        client[i] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        set_blocking(client[i], FALSE);
+        ret = connect(client[i], (struct sockaddr *)&address, sizeof(address));
+        ok(ret == -1, "got %d\n", ret);
+        ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %u\n", WSAGetLastError());
+
+        /* a socket reported writable after a non-blocking connect is connected */
+        for (j = 0; j < 100; ++j)
+        {
+            if (!i || !pWSAPoll)
+            {
+                FD_ZERO(&writefds);
+                FD_SET(client[i], &writefds);
+                if ((ret = select(0, NULL, &writefds, NULL, &zero))) break;
+            }
+            else
+            {
+                fds[0].fd = client[i];
+                fds[0].events = POLLWRNORM;
+                fds[0].revents = 0xdead;
+                if ((ret = pWSAPoll(fds, 1, 0)))
+                {
+                    ok(fds[0].revents == POLLWRNORM, "got events %#x\n", fds[0].revents);
+                    break;
+                }
+            }
+            Sleep(10);
+        }
+        ok(ret == 1, "got %d\n", ret);
+
+        len = sizeof(peer);
+        ret = getpeername(client[i], (struct sockaddr *)&peer, &len);
+        ok(!ret, "got error %u\n", WSAGetLastError());
+        ok(peer.sin_port == address.sin_port, "got port %u\n", ntohs(peer.sin_port));
+        ret = shutdown(client[i], SD_SEND);
+        ok(!ret, "got error %u\n", WSAGetLastError());
+    }
+
+    /* the listener has pending connections */
+    FD_ZERO(&readfds);
+    FD_SET(listener, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(ret == 1, "got %d\n", ret);
+    ok(FD_ISSET(listener, &readfds), "listener should be readable\n");
+    if (pWSAPoll)
+    {
+        fds[0].fd = listener;
+        fds[0].events = POLLRDNORM | POLLWRNORM;
+        fds[0].revents = 0xdead;
+        ret = pWSAPoll(fds, 1, 0);
+        ok(ret == 1, "got %d\n", ret);
+        ok(fds[0].revents == POLLRDNORM, "got events %#x\n", fds[0].revents);
+    }
+
+    /* the accepted socket is at end of stream */
+    server = accept(listener, NULL, NULL);
+    ok(server != INVALID_SOCKET, "got error %u\n", WSAGetLastError());
+    for (j = 0; j < 100; ++j)
+    {
+        FD_ZERO(&readfds);
+        FD_SET(server, &readfds);
+        if ((ret = select(0, &readfds, NULL, NULL, &zero))) break;
+        Sleep(10);
+    }
+    ok(ret == 1, "got %d\n", ret);
+    if (pWSAPoll)
+    {
+        fds[0].fd = server;
+        fds[0].events = POLLRDNORM;
+        fds[0].revents = 0xdead;
+        ret = pWSAPoll(fds, 1, 0);
+        ok(ret == 1, "got %d\n", ret);
+        ok(fds[0].revents && !(fds[0].revents & ~(POLLRDNORM | POLLHUP)), "got events %#x\n", fds[0].revents);
+    }
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(!ret, "got %d\n", ret);
+
+    closesocket(server);
+    for (i = 0; i < ARRAY_SIZE(client); ++i) closesocket(client[i]);
+    closesocket(listener);
+}
+
+/* readiness consumed by a pending overlapped request is not reported to select() */
+static void test_poll_pending_async(void)
+{
+    const struct sockaddr_in bind_addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    const struct timeval zero = {0};
+    GUID acceptex_guid = WSAID_ACCEPTEX;
+    SOCKET listener, client, server, sender, receiver;
+    char buffer[64], data[] = "test";
+    OVERLAPPED overlapped = {0};
+    struct sockaddr_in address;
+    LPFN_ACCEPTEX pAcceptEx;
+    WSABUF wsabuf;
+    fd_set readfds;
+    DWORD size, flags;
+    int ret, len;
+
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    receiver = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = bind(receiver, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(address);
+    ret = getsockname(receiver, (struct sockaddr *)&address, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    flags = 0;
+    ret = WSARecv(receiver, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(ret == -1, "got %d\n", ret);
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+
+    ret = sendto(sender, data, sizeof(data), 0, (struct sockaddr *)&address, sizeof(address));
+    ok(ret == sizeof(data), "got %d\n", ret);
+
+    FD_ZERO(&readfds);
+    FD_SET(receiver, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(!ret, "got %d\n", ret);
+
+    ret = WaitForSingleObject(overlapped.hEvent, 1000);
+    ok(!ret, "got %d\n", ret);
+    ret = WSAGetOverlappedResult(receiver, &overlapped, &size, FALSE, &flags);
+    ok(ret, "got error %u\n", WSAGetLastError());
+    ok(size == sizeof(data), "got size %lu\n", size);
+
+    /* with no request pending the next datagram is reported */
+    ret = sendto(sender, data, sizeof(data), 0, (struct sockaddr *)&address, sizeof(address));
+    ok(ret == sizeof(data), "got %d\n", ret);
+    FD_ZERO(&readfds);
+    FD_SET(receiver, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(ret == 1, "got %d\n", ret);
+
+    closesocket(sender);
+    closesocket(receiver);
+
+    listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ret = WSAIoctl(listener, SIO_GET_EXTENSION_FUNCTION_POINTER, &acceptex_guid, sizeof(acceptex_guid),
+            &pAcceptEx, sizeof(pAcceptEx), &size, NULL, NULL);
+    ok(!ret, "failed to get AcceptEx, error %u\n", WSAGetLastError());
+    ret = bind(listener, (const struct sockaddr *)&bind_addr, sizeof(bind_addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(address);
+    ret = getsockname(listener, (struct sockaddr *)&address, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ret = listen(listener, 1);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    ResetEvent(overlapped.hEvent);
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ret = pAcceptEx(listener, server, buffer, 0, 0, sizeof(struct sockaddr_in) + 16, NULL, &overlapped);
+    ok(!ret, "got %d\n", ret);
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+
+    client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ret = connect(client, (struct sockaddr *)&address, sizeof(address));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    FD_ZERO(&readfds);
+    FD_SET(listener, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(!ret, "got %d\n", ret);
+
+    ret = WaitForSingleObject(overlapped.hEvent, 1000);
+    ok(!ret, "got %d\n", ret);
+    ret = GetOverlappedResult((HANDLE)listener, &overlapped, &size, FALSE);
+    ok(ret, "got error %lu\n", GetLastError());
+
+    closesocket(server);
+    closesocket(client);
+    closesocket(listener);
+    CloseHandle(overlapped.hEvent);
+}
+
 static void test_connect(void)
 {
     SOCKET listener = INVALID_SOCKET;
@@ -12965,6 +13171,92 @@ static void test_simultaneous_async_recv(void)
     for (i = 0; i < num_io; i++) CloseHandle(events[i]);
 }
 
+static void test_simultaneous_async_recvfrom(void)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    struct sockaddr_in from[6], dst_addr;
+    OVERLAPPED overlappeds[6] = {{0}};
+    HANDLE events[6];
+    WSABUF wsabufs[6];
+    DWORD flags[6] = {0};
+    int fromlen[6], len, ret;
+    char bufs[6][16];
+    char msg[16];
+    SOCKET client, server;
+    unsigned int i;
+
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ok(client != INVALID_SOCKET, "got error %u\n", WSAGetLastError());
+    ret = bind(client, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(dst_addr);
+    ret = getsockname(client, (struct sockaddr *)&dst_addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ok(server != INVALID_SOCKET, "got error %u\n", WSAGetLastError());
+    ret = bind(server, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+
+    for (i = 0; i < ARRAY_SIZE(overlappeds); i++)
+    {
+        events[i] = CreateEventW(NULL, TRUE, FALSE, NULL);
+        wsabufs[i].buf = bufs[i];
+        wsabufs[i].len = sizeof(bufs[i]);
+        overlappeds[i].hEvent = events[i];
+        fromlen[i] = sizeof(from[i]);
+        memset(&from[i], 0, sizeof(from[i]));
+        ret = WSARecvFrom(client, &wsabufs[i], 1, NULL, &flags[i], (struct sockaddr *)&from[i],
+                &fromlen[i], &overlappeds[i], NULL);
+        ok(ret == -1, "got %d\n", ret);
+        ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+    }
+
+    /* datagrams complete the pending requests in order, the others keep waiting */
+    for (i = 0; i < 4; i++)
+    {
+        sprintf(msg, "datagram %u", i);
+        ret = sendto(server, msg, strlen(msg), 0, (struct sockaddr *)&dst_addr, sizeof(dst_addr));
+        ok(ret == strlen(msg), "got %d\n", ret);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(overlappeds); i++)
+    {
+        DWORD size = 0;
+
+        if (i == 4)
+        {
+            ret = WaitForSingleObject(events[i], 100);
+            ok(ret == WAIT_TIMEOUT, "got %d\n", ret);
+
+            sprintf(msg, "datagram %u", i);
+            ret = sendto(server, msg, strlen(msg), 0, (struct sockaddr *)&dst_addr, sizeof(dst_addr));
+            ok(ret == strlen(msg), "got %d\n", ret);
+            ret = sendto(server, "datagram 5", 10, 0, (struct sockaddr *)&dst_addr, sizeof(dst_addr));
+            ok(ret == 10, "got %d\n", ret);
+        }
+
+        ret = WaitForSingleObject(events[i], 1000);
+        ok(!ret, "%u: wait timed out\n", i);
+
+        sprintf(msg, "datagram %u", i);
+        ret = GetOverlappedResult((HANDLE)client, &overlappeds[i], &size, FALSE);
+        ok(ret, "%u: got error %lu\n", i, GetLastError());
+        ok(size == strlen(msg), "%u: got size %lu\n", i, size);
+        ok(!memcmp(bufs[i], msg, strlen(msg)), "%u: got %s\n", i, debugstr_an(bufs[i], size));
+        ok(fromlen[i] == sizeof(addr), "%u: got address length %d\n", i, fromlen[i]);
+        ok(from[i].sin_port == addr.sin_port, "%u: got port %u\n", i, ntohs(from[i].sin_port));
+    }
+
+    closesocket(client);
+    closesocket(server);
+
+    for (i = 0; i < ARRAY_SIZE(overlappeds); i++) CloseHandle(events[i]);
+}
+
 static void test_empty_recv(void)
 {
     OVERLAPPED overlapped = {0};
@@ -13884,6 +14176,8 @@ START_TEST( sock )
     test_WSASendTo();
     test_WSARecv();
     test_WSAPoll();
+    test_poll_zero_timeout();
+    test_poll_pending_async();
     test_write_watch();
     test_iocp();
 
@@ -13904,6 +14198,7 @@ START_TEST( sock )
     test_WSAGetOverlappedResult();
     test_nonblocking_async_recv();
     test_simultaneous_async_recv();
+    test_simultaneous_async_recvfrom();
     test_empty_recv();
     test_timeout();
     test_tcp_reset();
@@ -509,6 +509,7 @@ typedef union
         client_ptr_t     user;
         client_ptr_t     sb;
         data_size_t      result;
+        unsigned int     batch;
     } async_io;
     struct
     {
@@ -6356,7 +6357,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 758
+#define SERVER_PROTOCOL_VERSION 761
 
 /* ### protocol_version end ### */
 
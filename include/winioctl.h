@@ -593,6 +593,13 @@ typedef struct RETRIEVAL_POINTERS_BUFFER {
 
 /* End: _WIN32_WINNT >= 0x0400 */
 
+typedef struct _DUPLICATE_EXTENTS_DATA {
+    HANDLE        FileHandle;
+    LARGE_INTEGER SourceFileOffset;
+    LARGE_INTEGER TargetFileOffset;
+    LARGE_INTEGER ByteCount;
+} DUPLICATE_EXTENTS_DATA, *PDUPLICATE_EXTENTS_DATA;
+
 /*
  *	NT I/O-Manager
  */
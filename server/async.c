@@ -57,6 +57,8 @@ struct async
     unsigned int         canceled :1;     /* have we already queued cancellation for this async? */
     unsigned int         unknown_status :1; /* initial status is not known yet */
     unsigned int         blocking :1;     /* async is blocking */
+    unsigned int         batch_pos;       /* position in a batch of asyncs alerted together, 0 if none */
+    unsigned int         batch_size;      /* number of asyncs in that batch */
     struct completion   *completion;      /* completion associated with fd */
     apc_param_t          comp_key;        /* completion key associated with fd */
     unsigned int         comp_flags;      /* completion flags */
@@ -187,6 +189,7 @@ void async_terminate( struct async *async, unsigned int status )
         data.type            = APC_ASYNC_IO;
         data.async_io.user   = async->data.user;
         data.async_io.result = iosb ? iosb->result : 0;
+        if (async->batch_pos == 1) data.async_io.batch = async->batch_size - 1;
 
         /* this can happen if the initial status was unknown (i.e. for device
          * files). the client should not fill the IOSB in this case; pass it as
@@ -279,6 +282,8 @@ struct async *create_async( struct fd *fd, struct thread *thread, const async_da
     async->canceled      = 0;
     async->unknown_status = 0;
     async->blocking      = !is_fd_overlapped( fd );
+    async->batch_pos     = 0;
+    async->batch_size    = 0;
     async->completion    = fd_get_completion( fd, &async->comp_key );
     async->comp_flags    = 0;
     async->completion_callback = NULL;
@@ -495,6 +500,19 @@ void async_set_result( struct object *obj, unsigned int status, apc_param_t tota
 
     if (async->unknown_status) async_set_initial_status( async, status );
 
+    if (async->batch_pos && async->queue)
+    {
+        struct async_queue *queue = async->queue;
+
+        /* shrink the next batch if this one was larger than the available data,
+         * grow it if the whole batch could be completed */
+        if (async->alerted && status == STATUS_PENDING)
+            queue->batch = max( 1, min( queue->batch, async->batch_pos - 1 ));
+        else if (async->batch_pos == async->batch_size && async->batch_size == queue->batch)
+            queue->batch = min( queue->batch * 2, MAX_ASYNC_BATCH );
+    }
+    async->batch_pos = async->batch_size = 0;
+
     if (async->alerted && status == STATUS_PENDING)  /* restart it */
     {
         async->terminated = 0;
@@ -667,6 +685,36 @@ void async_wake_up( struct async_queue *queue, unsigned int status )
     }
 }
 
+/* wake up the first async on the queue, along with the following waiting asyncs of the
+ * same thread and handle, so that the client can serve them with a single system call */
+void async_wake_up_batch( struct async_queue *queue )
+{
+    struct async *head, *async, *batch[MAX_ASYNC_BATCH];
+    unsigned int i, count = 1;
+    struct list *ptr;
+
+    if (!(ptr = list_head( &queue->queue ))) return;
+    head = batch[0] = LIST_ENTRY( ptr, struct async, queue_entry );
+    if (head->terminated) return;
+
+    if (!queue->batch) queue->batch = 1;
+    while (count < queue->batch && (ptr = list_next( &queue->queue, ptr )))
+    {
+        async = LIST_ENTRY( ptr, struct async, queue_entry );
+        if (async->terminated || async->direct_result || async->thread != head->thread ||
+            async->data.handle != head->data.handle)
+            break;
+        batch[count++] = async;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        batch[i]->batch_pos = i + 1;
+        batch[i]->batch_size = count;
+    }
+    for (i = 0; i < count; i++) async_terminate( batch[i], STATUS_ALERTED );
+}
+
 static void iosb_dump( struct object *obj, int verbose );
 static void iosb_destroy( struct object *obj );
 
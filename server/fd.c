@@ -147,6 +147,14 @@ static inline int epoll_wait( int epfd, struct epoll_event *events, int maxevent
 
 #endif /* linux && __i386__ && HAVE_STDINT_H */
 
+#if defined(USE_EPOLL) && defined(HAVE_SYS_EPOLL_H) && defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+# include <sys/mman.h>
+# include <linux/io_uring.h>
+# ifdef IORING_FEAT_EXT_ARG
+#  define USE_IO_URING
+# endif
+#endif
+
 #if defined(HAVE_PORT_H) && defined(HAVE_PORT_CREATE)
 # include <port.h>
 # define USE_EVENT_PORTS
@@ -189,6 +197,9 @@ struct fd
     unsigned int         signaled :1; /* is the fd signaled? */
     unsigned int         fs_locks :1; /* can we use filesystem locks for this fd? */
     int                  poll_index;  /* index of fd in poll array */
+#ifdef USE_IO_URING
+    unsigned int         uring_seq;   /* sequence number of the armed io_uring poll, 0 if none */
+#endif
     struct async_queue   read_q;      /* async readers of this fd */
     struct async_queue   write_q;     /* async writers of this fd */
     struct async_queue   wait_q;      /* other async waiters of this fd */
@@ -556,10 +567,246 @@ static inline void fd_poll_event( struct fd *fd, int event )
 
 #ifdef USE_EPOLL
 
+#ifdef USE_IO_URING
+
+/* The io_uring variant uses one-shot poll requests that are re-armed after each event,
+ * to keep the level-triggered semantics of epoll. Registration changes are only queued
+ * in the submission ring, and get submitted together with the next wait. */
+
+#define URING_FEATURES (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG)
+
+static int uring_fd = -1;
+static unsigned int uring_seq;              /* sequence number of the last armed poll */
+static unsigned int sq_pending;             /* number of queued entries not submitted yet */
+static unsigned int sq_entries;             /* size of the submission ring */
+static unsigned int sq_mask, cq_mask;
+static unsigned int *sq_head, *sq_tail, *sq_array;
+static unsigned int *cq_head, *cq_tail;
+static struct io_uring_sqe *sqes;
+static struct io_uring_cqe *cqes;
+
+static inline int io_uring_setup( unsigned int entries, struct io_uring_params *params )
+{
+    return syscall( __NR_io_uring_setup, entries, params );
+}
+
+static inline int io_uring_enter( int fd, unsigned int to_submit, unsigned int min_complete,
+                                  unsigned int flags, void *arg, size_t size )
+{
+    return syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, size );
+}
+
+/* poll requests are tagged with the user index and the poll sequence number, 0 is used for removals */
+static inline __u64 uring_user_data( int user, unsigned int seq )
+{
+    return ((__u64)seq << 32) | (unsigned int)user;
+}
+
+static int init_uring(void)
+{
+    struct io_uring_params params;
+    const char *env = getenv( "WINESERVER_IO_URING" );
+    size_t ring_size;
+    char *ring;
+    int fd;
+
+    if (!env || !atoi( env )) return 0;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = io_uring_setup( 256, &params )) == -1) return 0;
+    if ((params.features & URING_FEATURES) != URING_FEATURES) goto failed;
+
+    ring_size = max( params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                     params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) );
+    ring = mmap( NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 fd, IORING_OFF_SQ_RING );
+    if (ring == MAP_FAILED) goto failed;
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (sqes == MAP_FAILED)
+    {
+        munmap( ring, ring_size );
+        goto failed;
+    }
+
+    sq_entries = params.sq_entries;
+    sq_mask  = *(unsigned int *)(ring + params.sq_off.ring_mask);
+    sq_head  = (unsigned int *)(ring + params.sq_off.head);
+    sq_tail  = (unsigned int *)(ring + params.sq_off.tail);
+    sq_array = (unsigned int *)(ring + params.sq_off.array);
+    cq_mask  = *(unsigned int *)(ring + params.cq_off.ring_mask);
+    cq_head  = (unsigned int *)(ring + params.cq_off.head);
+    cq_tail  = (unsigned int *)(ring + params.cq_off.tail);
+    cqes     = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+    uring_fd = fd;
+    if (debug_level) fprintf( stderr, "wineserver: using io_uring for polling\n" );
+    return 1;
+
+failed:
+    close( fd );
+    return 0;
+}
+
+/* give up on io_uring, the poll() loop will take over */
+static void uring_failed( const char *func )
+{
+    perror( func );
+    close( uring_fd );
+    uring_fd = -1;
+}
+
+static void submit_uring(void)
+{
+    int ret;
+
+    if (uring_fd == -1 || !sq_pending) return;
+    if ((ret = io_uring_enter( uring_fd, sq_pending, 0, 0, NULL, 0 )) == -1)
+        uring_failed( "io_uring_enter" );
+    else
+        sq_pending -= ret;
+}
+
+static void queue_uring_sqe( __u8 opcode, int unix_fd, __u64 addr, __u32 events, __u64 user_data )
+{
+    unsigned int tail = *sq_tail, index;
+    struct io_uring_sqe *sqe;
+
+    if (tail - __atomic_load_n( sq_head, __ATOMIC_ACQUIRE ) == sq_entries)  /* ring is full */
+    {
+        submit_uring();
+        if (uring_fd == -1) return;
+        if (tail - __atomic_load_n( sq_head, __ATOMIC_ACQUIRE ) == sq_entries)
+        {
+            errno = EBUSY;
+            uring_failed( "io_uring submit" );
+            return;
+        }
+    }
+
+    index = tail & sq_mask;
+    sqe = &sqes[index];
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode    = opcode;
+    sqe->fd        = unix_fd;
+    sqe->addr      = addr;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    events = (events << 16) | (events >> 16);
+#endif
+    sqe->poll32_events = events;
+    sqe->user_data = user_data;
+    sq_array[index] = index;
+    __atomic_store_n( sq_tail, tail + 1, __ATOMIC_RELEASE );
+    sq_pending++;
+}
+
+static void arm_uring_poll( struct fd *fd, int user, int events )
+{
+    if (!++uring_seq) uring_seq++;  /* skip 0 */
+    fd->uring_seq = uring_seq;
+    queue_uring_sqe( IORING_OP_POLL_ADD, fd->unix_fd, 0, events, uring_user_data( user, uring_seq ));
+}
+
+static void cancel_uring_poll( struct fd *fd, int user )
+{
+    if (!fd->uring_seq) return;
+    queue_uring_sqe( IORING_OP_POLL_REMOVE, -1, uring_user_data( user, fd->uring_seq ), 0, 0 );
+    fd->uring_seq = 0;
+}
+
+/* set the events that io_uring polls for on this fd; helper for set_fd_epoll_events */
+static inline void set_fd_uring_events( struct fd *fd, int user, int events )
+{
+    if (events != -1 && fd->uring_seq && pollfd[user].events == events) return;  /* nothing to do */
+
+    cancel_uring_poll( fd, user );
+    if (events != -1) arm_uring_poll( fd, user, events );
+    /* the poll request holds a reference to the file, make sure it goes away right now */
+    else submit_uring();
+}
+
+static inline void main_loop_uring(void)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    struct io_uring_cqe *cqe;
+    unsigned int head, tail, seq;
+    int i, ret, count, timeout, users[128];
+
+    while (active_users)
+    {
+        timeout = get_next_timeout();
+
+        if (!active_users) break;  /* last user removed by a timeout */
+        if (uring_fd == -1) break;  /* an error occurred with io_uring */
+
+        memset( &arg, 0, sizeof(arg) );
+        if (timeout != -1)
+        {
+            ts.tv_sec  = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            arg.ts = (unsigned long)&ts;
+        }
+        ret = io_uring_enter( uring_fd, sq_pending, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                              &arg, sizeof(arg) );
+        if (ret > 0) sq_pending -= ret;
+        else if (ret == -1 && errno != ETIME && errno != EINTR && errno != EBUSY)
+        {
+            uring_failed( "io_uring_enter" );
+            break;
+        }
+        set_current_time();
+
+        /* put the events into the pollfd array first, like poll does */
+        count = 0;
+        head = *cq_head;
+        tail = __atomic_load_n( cq_tail, __ATOMIC_ACQUIRE );
+        while (head != tail && count < ARRAY_SIZE( users ))
+        {
+            int user;
+
+            cqe = &cqes[head++ & cq_mask];
+            if (!cqe->user_data) continue;  /* poll removal */
+            user = (unsigned int)cqe->user_data;
+            seq = cqe->user_data >> 32;
+            /* ignore completions of polls that have been removed or re-armed since */
+            if (pollfd[user].fd == -1 || poll_users[user]->uring_seq != seq) continue;
+            poll_users[user]->uring_seq = 0;
+            if (cqe->res < 0)
+            {
+                fprintf( stderr, "io_uring poll: %s\n", strerror( -cqe->res ));
+                continue;
+            }
+            pollfd[user].revents = cqe->res;
+            users[count++] = user;
+        }
+        __atomic_store_n( cq_head, head, __ATOMIC_RELEASE );
+
+        /* read events from the pollfd array, as set_fd_events may modify them */
+        for (i = 0; i < count; i++)
+        {
+            int user = users[i];
+            if (pollfd[user].revents) fd_poll_event( poll_users[user], pollfd[user].revents );
+        }
+
+        /* re-arm the polls that fired, unless set_fd_events already did it */
+        for (i = 0; i < count && uring_fd != -1; i++)
+        {
+            int user = users[i];
+            if (pollfd[user].fd == -1 || poll_users[user]->uring_seq) continue;
+            arm_uring_poll( poll_users[user], user, pollfd[user].events );
+        }
+    }
+}
+
+#endif /* USE_IO_URING */
+
 static int epoll_fd = -1;
 
 static inline void init_epoll(void)
 {
+#ifdef USE_IO_URING
+    if (init_uring()) return;
+#endif
     epoll_fd = epoll_create( 128 );
 }
 
@@ -569,6 +816,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
     struct epoll_event ev;
     int ctl;
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        set_fd_uring_events( fd, user, events );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (events == -1)  /* stop waiting on this fd completely */
@@ -603,6 +857,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
 
 static inline void remove_epoll_user( struct fd *fd, int user )
 {
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        set_fd_uring_events( fd, user, -1 );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (pollfd[user].fd != -1)
@@ -622,6 +883,13 @@ static inline void main_loop_epoll(void)
     assert( POLLERR == EPOLLERR );
     assert( POLLHUP == EPOLLHUP );
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        main_loop_uring();
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     while (active_users)
@@ -1717,6 +1985,9 @@ static struct fd *alloc_fd_object(void)
     fd->signaled   = 1;
     fd->fs_locks   = 1;
     fd->poll_index = -1;
+#ifdef USE_IO_URING
+    fd->uring_seq  = 0;
+#endif
     fd->completion = NULL;
     fd->comp_flags = 0;
     fd->esync_fd   = -1;
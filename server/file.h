@@ -46,8 +46,11 @@ struct iosb
 struct async_queue
 {
     struct list queue;          /* queue of async objects */
+    unsigned int batch;         /* number of asyncs to alert together, see async_wake_up_batch() */
 };
 
+#define MAX_ASYNC_BATCH 16
+
 /* operations valid on file descriptor objects */
 struct fd_ops
 {
@@ -191,6 +194,7 @@ extern struct memory_view *get_exe_view( struct process *process );
 extern struct file *get_view_file( const struct memory_view *view, unsigned int access, unsigned int sharing );
 extern const pe_image_info_t *get_view_image_info( const struct memory_view *view, client_ptr_t *base );
 extern int get_view_nt_name( const struct memory_view *view, struct unicode_str *name );
+extern void init_process_views( struct process *process );
 extern void free_mapped_views( struct process *process );
 extern int get_page_size(void);
 extern struct mapping *create_fd_mapping( struct object *root, const struct unicode_str *name, struct fd *fd,
@@ -255,6 +259,7 @@ extern void async_request_complete( struct async *async, unsigned int status, da
 extern void async_request_complete_alloc( struct async *async, unsigned int status, data_size_t result,
                                           data_size_t out_size, const void *out_data );
 extern void async_wake_up( struct async_queue *queue, unsigned int status );
+extern void async_wake_up_batch( struct async_queue *queue );
 extern struct completion *fd_get_completion( struct fd *fd, apc_param_t *p_key );
 extern void fd_copy_completion( struct fd *src, struct fd *dst );
 extern struct iosb *async_get_iosb( struct async *async );
@@ -267,6 +272,7 @@ extern int async_close_obj_handle( struct object *obj, struct process *process,
 static inline void init_async_queue( struct async_queue *queue )
 {
     list_init( &queue->queue );
+    queue->batch = 1;
 }
 
 static inline int async_queued( struct async_queue *queue )
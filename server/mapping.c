@@ -126,13 +126,35 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* copy of a PE image relocated to a given address, shared by the processes loading it there;
+ * the PE file is identified by its stat information, since holding its fd would keep it
+ * mapped as an image, and prevent replacing it, after all processes have unloaded it */
+struct reloc_image
+{
+    struct list     entry;           /* entry in global relocated images list */
+    struct stat     st;              /* stat information of the PE file */
+    struct file    *file;            /* temp file holding the relocated image */
+    client_ptr_t    base;            /* address the image is relocated to */
+    unsigned int    views;           /* number of views mapped from the relocated image */
+    int             ready;           /* the file has been filled */
+    int             failed;          /* the image can't be relocated there, don't try again */
+    int             cached;          /* the image is in the global list */
+};
+
+#define MAX_RELOC_IMAGES 32
+
+static struct list reloc_image_list = LIST_INIT( reloc_image_list );
+static unsigned int reloc_image_count;
+
 /* memory view mapped in client address space */
 struct memory_view
 {
     struct list     entry;           /* entry in per-process view list */
+    struct wine_rb_entry tree_entry; /* entry in per-process view tree */
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct reloc_image *reloc;       /* relocated copy of the PE image */
     pe_image_info_t image;           /* image info (for PE image mapping) */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
@@ -359,14 +381,45 @@ static int create_temp_file( file_pos_t size )
     return fd;
 }
 
+/* address range used as a key in the process view tree */
+struct view_range
+{
+    client_ptr_t base;
+    mem_size_t   size;
+};
+
+/* views never overlap, so any overlap with the key is a match */
+static int compare_view_range( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct memory_view *view = WINE_RB_ENTRY_VALUE( entry, struct memory_view, tree_entry );
+    const struct view_range *range = key;
+
+    if (range->base + range->size <= view->base) return -1;
+    if (range->base >= view->base + view->size) return 1;
+    return 0;
+}
+
+void init_process_views( struct process *process )
+{
+    wine_rb_init( &process->view_tree, compare_view_range );
+}
+
+/* find a memory view overlapping the given range */
+static struct memory_view *find_view_range( struct process *process, client_ptr_t base, mem_size_t size )
+{
+    struct view_range range = { base, size };
+    struct wine_rb_entry *entry;
+
+    if (!(entry = wine_rb_get( &process->view_tree, &range ))) return NULL;
+    return WINE_RB_ENTRY_VALUE( entry, struct memory_view, tree_entry );
+}
+
 /* find a memory view from its base address */
 struct memory_view *find_mapped_view( struct process *process, client_ptr_t base )
 {
-    struct memory_view *view;
-
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (view->base == base) return view;
+    struct memory_view *view = find_view_range( process, base, 1 );
 
+    if (view && view->base == base) return view;
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
 }
@@ -374,11 +427,9 @@ struct memory_view *find_mapped_view( struct process *process, client_ptr_t base
 /* find a memory view from any address inside it */
 static struct memory_view *find_mapped_addr( struct process *process, client_ptr_t addr )
 {
-    struct memory_view *view;
-
-    LIST_FOR_EACH_ENTRY( view, &process->views, struct memory_view, entry )
-        if (addr >= view->base && addr < view->base + view->size) return view;
+    struct memory_view *view = find_view_range( process, addr, 1 );
 
+    if (view) return view;
     set_error( STATUS_NOT_MAPPED_VIEW );
     return NULL;
 }
@@ -415,8 +466,11 @@ static int generate_dll_event( struct thread *thread, int code, struct memory_vi
 static void add_process_view( struct thread *thread, struct memory_view *view )
 {
     struct process *process = thread->process;
+    struct view_range range = { view->base, view->size };
     struct unicode_str name;
 
+    wine_rb_put( &process->view_tree, &range, &view->tree_entry );
+
     if (view->flags & SEC_IMAGE)
     {
         if (is_process_init_done( process ))
@@ -440,11 +494,92 @@ static void add_process_view( struct thread *thread, struct memory_view *view )
     list_add_tail( &process->views, &view->entry );
 }
 
-static void free_memory_view( struct memory_view *view )
+/* check that the PE file of a relocated image hasn't been modified since */
+static int is_reloc_image_current( const struct reloc_image *image, const struct stat *st )
+{
+    if (image->st.st_size != st->st_size) return 0;
+    if (image->st.st_mtime != st->st_mtime || image->st.st_ctime != st->st_ctime) return 0;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    if (image->st.st_mtim.tv_nsec != st->st_mtim.tv_nsec) return 0;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    if (image->st.st_mtimespec.tv_nsec != st->st_mtimespec.tv_nsec) return 0;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_CTIM
+    if (image->st.st_ctim.tv_nsec != st->st_ctim.tv_nsec) return 0;
+#elif defined(HAVE_STRUCT_STAT_ST_CTIMESPEC)
+    if (image->st.st_ctimespec.tv_nsec != st->st_ctimespec.tv_nsec) return 0;
+#endif
+    return 1;
+}
+
+/* remove a relocated image from the cache, it's freed once no view uses it anymore */
+static void uncache_reloc_image( struct reloc_image *image )
+{
+    list_remove( &image->entry );
+    image->cached = 0;
+    reloc_image_count--;
+    if (image->views) return;
+    if (image->file) release_object( image->file );
+    free( image );
+}
+
+/* release a view reference on a relocated image, the pages aren't kept once all processes unmapped it */
+static void release_reloc_image( struct reloc_image *image )
+{
+    if (--image->views) return;
+    if (image->cached) uncache_reloc_image( image );
+    else
+    {
+        if (image->file) release_object( image->file );
+        free( image );
+    }
+}
+
+/* find the relocated copy of an image file, most recently used first */
+static struct reloc_image *find_reloc_image( const struct stat *st, client_ptr_t base )
+{
+    struct reloc_image *image;
+
+    LIST_FOR_EACH_ENTRY( image, &reloc_image_list, struct reloc_image, entry )
+    {
+        if (image->base != base || image->st.st_dev != st->st_dev || image->st.st_ino != st->st_ino) continue;
+        if (!is_reloc_image_current( image, st ))
+        {
+            uncache_reloc_image( image );
+            return NULL;
+        }
+        list_remove( &image->entry );
+        list_add_head( &reloc_image_list, &image->entry );
+        return image;
+    }
+    return NULL;
+}
+
+/* find the relocated copy used by a view of an image mapping */
+static struct reloc_image *get_view_reloc_image( struct mapping *mapping, client_ptr_t base )
+{
+    struct reloc_image *image;
+    struct stat st;
+    int unix_fd;
+
+    if (list_empty( &reloc_image_list )) return NULL;
+    if (!mapping->fd || (unix_fd = get_unix_fd( mapping->fd )) == -1 || fstat( unix_fd, &st ) == -1)
+    {
+        clear_error();
+        return NULL;
+    }
+    if (!(image = find_reloc_image( &st, base )) || !image->ready) return NULL;
+    image->views++;
+    return image;
+}
+
+static void free_memory_view( struct process *process, struct memory_view *view )
 {
+    wine_rb_remove( &process->view_tree, &view->tree_entry );
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->reloc) release_reloc_image( view->reloc );
     list_remove( &view->entry );
     free( view );
 }
@@ -455,7 +590,7 @@ void free_mapped_views( struct process *process )
     struct list *ptr;
 
     while ((ptr = list_head( &process->views )))
-        free_memory_view( LIST_ENTRY( ptr, struct memory_view, entry ));
+        free_memory_view( process, LIST_ENTRY( ptr, struct memory_view, entry ));
 }
 
 /* find the shared PE mapping for a given mapping */
@@ -1255,6 +1390,89 @@ DECL_HANDLER(get_mapping_info)
     release_object( mapping );
 }
 
+/* get the file holding the relocated copy of an image */
+DECL_HANDLER(get_image_reloc_file)
+{
+    struct mapping *mapping;
+    struct reloc_image *image;
+    struct stat st;
+    int unix_fd;
+
+    if (!(mapping = get_mapping_obj( current->process, req->mapping, SECTION_MAP_READ ))) return;
+
+    if (!(mapping->flags & SEC_IMAGE) || !mapping->fd || mapping->shared)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        release_object( mapping );
+        return;
+    }
+    if ((unix_fd = get_unix_fd( mapping->fd )) == -1 || fstat( unix_fd, &st ) == -1)
+    {
+        if (unix_fd != -1) file_set_error();
+        release_object( mapping );
+        return;
+    }
+
+    if ((image = find_reloc_image( &st, req->base )))
+    {
+        /* another process may still be filling it, don't wait for it */
+        if (image->ready)
+        {
+            reply->file  = alloc_handle( current->process, image->file, GENERIC_READ, 0 );
+            reply->ready = 1;
+        }
+        release_object( mapping );
+        return;
+    }
+
+    if (reloc_image_count >= MAX_RELOC_IMAGES)
+        uncache_reloc_image( LIST_ENTRY( list_tail( &reloc_image_list ), struct reloc_image, entry ));
+
+    if ((unix_fd = create_temp_file( mapping->image.map_size )) != -1 && (image = mem_alloc( sizeof(*image) )))
+    {
+        if ((image->file = create_file_for_fd( unix_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 )))
+        {
+            image->st     = st;
+            image->base   = req->base;
+            image->views  = 0;
+            image->ready  = 0;
+            image->failed = 0;
+            image->cached = 1;
+            list_add_head( &reloc_image_list, &image->entry );
+            reloc_image_count++;
+            reply->file = alloc_handle( current->process, image->file, GENERIC_READ|GENERIC_WRITE, 0 );
+        }
+        else free( image );
+    }
+    else if (unix_fd != -1) close( unix_fd );
+    release_object( mapping );
+}
+
+/* mark the relocated copy of an image as usable by other processes */
+DECL_HANDLER(set_image_reloc_file)
+{
+    struct mapping *mapping;
+    struct reloc_image *image;
+    struct stat st;
+    int unix_fd;
+
+    if (!(mapping = get_mapping_obj( current->process, req->mapping, SECTION_MAP_READ ))) return;
+
+    if (mapping->fd && (unix_fd = get_unix_fd( mapping->fd )) != -1 && !fstat( unix_fd, &st ) &&
+        (image = find_reloc_image( &st, req->base )) && !image->ready && !image->failed)
+    {
+        if (req->success) image->ready = 1;
+        else
+        {
+            /* remember the failure, so that other processes don't copy the image again for nothing */
+            image->failed = 1;
+            release_object( image->file );
+            image->file = NULL;
+        }
+    }
+    release_object( mapping );
+}
+
 /* add a memory view in the current process */
 DECL_HANDLER(map_view)
 {
@@ -1269,10 +1487,8 @@ DECL_HANDLER(map_view)
     }
 
     /* make sure we don't already have an overlapping view */
-    LIST_FOR_EACH_ENTRY( view, &current->process->views, struct memory_view, entry )
+    if (find_view_range( current->process, req->base, req->size ))
     {
-        if (view->base + view->size <= req->base) continue;
-        if (view->base >= req->base + req->size) continue;
         set_error( STATUS_INVALID_PARAMETER );
         return;
     }
@@ -1321,7 +1537,12 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
-        if (view->flags & SEC_IMAGE) view->image = mapping->image;
+        view->reloc     = NULL;
+        if (view->flags & SEC_IMAGE)
+        {
+            view->image = mapping->image;
+            if (view->base != mapping->image.base) view->reloc = get_view_reloc_image( mapping, view->base );
+        }
         add_process_view( current, view );
         if (view->flags & SEC_IMAGE && view->base != mapping->image.base)
             set_error( STATUS_IMAGE_NOT_AT_BASE );
@@ -1338,7 +1559,7 @@ DECL_HANDLER(unmap_view)
 
     if (!view) return;
     generate_dll_event( current, DbgUnloadDllStateChange, view );
-    free_memory_view( view );
+    free_memory_view( current->process, view );
 }
 
 /* get a range of committed pages in a file mapping */
@@ -83,10 +83,12 @@ struct key
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
     struct key      **subkeys;     /* subkeys array */
+    struct name_hash *subkey_hash; /* hash index of subkey names */
     struct key       *wow6432node; /* Wow6432Node subkey */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
+    struct name_hash *value_hash;  /* hash index of value names */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
     struct list       notify_list; /* list of notifications */
@@ -115,6 +117,14 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define MIN_HASHED   64  /* min. number of subkeys or values to build a hash index */
+
+/* open-addressing hash index of the subkey or value names of a key, by array index */
+struct name_hash
+{
+    unsigned int size;       /* number of slots, a power of 2 */
+    int          index[1];   /* array index of each entry, -1 if slot is free */
+};
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -131,7 +141,7 @@ static const WCHAR wow6432node[] = {'W','o','w','6','4','3','2','N','o','d','e'}
 static const WCHAR symlink_value[] = {'S','y','m','b','o','l','i','c','L','i','n','k','V','a','l','u','e'};
 static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_value) };
 
-static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
+static struct key_value *find_value( struct key *key, const struct unicode_str *name, int *index );
 
 /* information about where to save a registry branch */
 struct save_branch_info
@@ -158,6 +168,12 @@ struct file_load_info
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    WCHAR      *path;     /* path of the last loaded key */
+    data_size_t pathlen;  /* length of the last path in bytes */
+    data_size_t pathsize; /* size of the path buffer */
+    struct key **keys;    /* keys for each element of the last path */
+    int         depth;    /* number of keys in the last path */
+    int         maxdepth; /* size of the keys array */
 };
 
 
@@ -236,6 +252,8 @@ static void dump_path( const struct key *key, const struct key *base, FILE *f )
 /* dump a value to a text file */
 static void dump_value( const struct key_value *value, FILE *f )
 {
+    static const char hex[16] = "0123456789abcdef";
+    char buffer[256], *pos = buffer;
     unsigned int i, dw;
     int count;
 
@@ -273,26 +291,154 @@ static void dump_value( const struct key_value *value, FILE *f )
     else count += fprintf( f, "hex(%x):", value->type );
     for (i = 0; i < value->len; i++)
     {
-        count += fprintf( f, "%02x", *((unsigned char *)value->data + i) );
+        unsigned char byte = ((unsigned char *)value->data)[i];
+
+        /* format the bytes in a local buffer, this is much faster than fprintf for large values */
+        if (pos > buffer + sizeof(buffer) - 8)
+        {
+            fwrite( buffer, pos - buffer, 1, f );
+            pos = buffer;
+        }
+        *pos++ = hex[byte >> 4];
+        *pos++ = hex[byte & 0x0f];
+        count += 2;
         if (i < value->len-1)
         {
-            fputc( ',', f );
+            *pos++ = ',';
             if (++count > 76)
             {
-                fprintf( f, "\\\n  " );
+                memcpy( pos, "\\\n  ", 4 );
+                pos += 4;
                 count = 2;
             }
         }
     }
-    fputc( '\n', f );
+    *pos++ = '\n';
+    fwrite( buffer, pos - buffer, 1, f );
+}
+
+static const WCHAR *get_subkey_name( const struct key *key, int index, data_size_t *len )
+{
+    *len = key->subkeys[index]->obj.name->len;
+    return key->subkeys[index]->obj.name->name;
+}
+
+static const WCHAR *get_value_name( const struct key *key, int index, data_size_t *len )
+{
+    *len = key->values[index].namelen;
+    return key->values[index].name;
+}
+
+typedef const WCHAR *(*get_name_func)( const struct key *key, int index, data_size_t *len );
+
+/* return the slot where the entry at the given array index starts its probe sequence */
+static unsigned int name_hash_start( const struct name_hash *hash, const struct key *key,
+                                     int index, get_name_func get_name )
+{
+    data_size_t len;
+    const WCHAR *name = get_name( key, index, &len );
+    return hash_strW( name, len, hash->size );
+}
+
+static void name_hash_add( struct name_hash *hash, unsigned int i, int index )
+{
+    while (hash->index[i] != -1) i = (i + 1) & (hash->size - 1);
+    hash->index[i] = index;
+}
+
+/* build a hash index of the count first names; return NULL if not worth it or out of memory */
+static struct name_hash *create_name_hash( const struct key *key, int count, get_name_func get_name )
+{
+    struct name_hash *hash;
+    unsigned int i, size = 2 * MIN_HASHED;
+
+    if (count < MIN_HASHED) return NULL;
+    while (size < 2 * count) size *= 2;
+    if (!(hash = malloc( offsetof( struct name_hash, index[size] ) ))) return NULL;
+    hash->size = size;
+    for (i = 0; i < size; i++) hash->index[i] = -1;
+    for (i = 0; i < count; i++) name_hash_add( hash, name_hash_start( hash, key, i, get_name ), i );
+    return hash;
+}
+
+/* look up a name in the hash index, return its array index or -1 */
+static int name_hash_find( const struct name_hash *hash, const struct key *key,
+                           const struct unicode_str *name, get_name_func get_name )
+{
+    unsigned int i = hash_strW( name->str, name->len, hash->size );
+    const WCHAR *str;
+    data_size_t len;
+
+    for ( ; hash->index[i] != -1; i = (i + 1) & (hash->size - 1))
+    {
+        str = get_name( key, hash->index[i], &len );
+        if (len == name->len && !memicmp_strW( str, name->str, len )) return hash->index[i];
+    }
+    return -1;
+}
+
+/* update the hash index after the named entry has been inserted in the array at the given index */
+static void name_hash_insert( struct name_hash **hash, const struct unicode_str *name, int index, int count )
+{
+    unsigned int i;
+
+    if (!*hash) return;
+    if (2 * count > (*hash)->size)
+    {
+        /* it will be rebuilt with a larger size on next lookup */
+        free( *hash );
+        *hash = NULL;
+        return;
+    }
+    if (index < count - 1)  /* not appended, shift the following indices */
+        for (i = 0; i < (*hash)->size; i++) if ((*hash)->index[i] >= index) (*hash)->index[i]++;
+    name_hash_add( *hash, hash_strW( name->str, name->len, (*hash)->size ), index );
+}
+
+/* update the hash index before the named entry at the given index is removed from the array */
+static void name_hash_remove( struct name_hash **hash, const struct key *key, const struct unicode_str *name,
+                              int index, int count, get_name_func get_name )
+{
+    unsigned int i, j, start, mask;
+
+    if (!*hash) return;
+    if (count - 1 < MIN_HASHED / 2)
+    {
+        free( *hash );
+        *hash = NULL;
+        return;
+    }
+    mask = (*hash)->size - 1;
+    for (j = hash_strW( name->str, name->len, (*hash)->size ); (*hash)->index[j] != index; j = (j + 1) & mask)
+        assert( (*hash)->index[j] != -1 );
+
+    /* move back the following entries of the cluster that can no longer be reached */
+    for (i = (j + 1) & mask; (*hash)->index[i] != -1; i = (i + 1) & mask)
+    {
+        start = name_hash_start( *hash, key, (*hash)->index[i], get_name );
+        if (((i - start) & mask) < ((i - j) & mask)) continue;
+        (*hash)->index[j] = (*hash)->index[i];
+        j = i;
+    }
+    (*hash)->index[j] = -1;
+
+    if (index < count - 1)
+        for (i = 0; i <= mask; i++) if ((*hash)->index[i] > index) (*hash)->index[i]--;
 }
 
 /* find the named child of a given key and return its index */
-static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+static struct key *find_subkey( struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
 
+    if (!key->subkey_hash) key->subkey_hash = create_name_hash( key, key->last_subkey + 1, get_subkey_name );
+    if (key->subkey_hash && (i = name_hash_find( key->subkey_hash, key, name, get_subkey_name )) != -1)
+    {
+        *index = i;
+        return key->subkeys[i];
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -606,6 +752,7 @@ static int key_link_name( struct object *obj, struct object_name *name, struct o
     for (i = ++parent_key->last_subkey; i > index; i--)
         parent_key->subkeys[i] = parent_key->subkeys[i - 1];
     parent_key->subkeys[index] = (struct key *)grab_object( key );
+    name_hash_insert( &parent_key->subkey_hash, &tmp, index, parent_key->last_subkey + 1 );
     if (is_wow6432node( name->name, name->len ) &&
         !is_wow6432node( parent_key->obj.name->name, parent_key->obj.name->len ))
         parent_key->wow6432node = key;
@@ -617,6 +764,7 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
 {
     struct key *key = (struct key *)obj;
     struct key *parent = (struct key *)name->parent;
+    struct unicode_str tmp;
     int i, nb_subkeys;
 
     if (!parent) return;
@@ -629,6 +777,9 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
 
     for (i = 0; i <= parent->last_subkey; i++) if (parent->subkeys[i] == key) break;
     assert( i <= parent->last_subkey );
+    tmp.str = name->name;
+    tmp.len = name->len;
+    name_hash_remove( &parent->subkey_hash, parent, &tmp, i, parent->last_subkey + 1, get_subkey_name );
     for ( ; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
     parent->last_subkey--;
     name->parent = NULL;
@@ -671,12 +822,14 @@ static void key_destroy( struct object *obj )
         free( key->values[i].data );
     }
     free( key->values );
+    free( key->value_hash );
     for (i = 0; i <= key->last_subkey; i++)
     {
         key->subkeys[i]->obj.name->parent = NULL;
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -705,10 +858,12 @@ static struct key *create_key_object( struct object *parent, const struct unicod
             key->last_subkey = -1;
             key->nb_subkeys  = 0;
             key->subkeys     = NULL;
+            key->subkey_hash = NULL;
             key->wow6432node = NULL;
             key->nb_values   = 0;
             key->last_value  = -1;
             key->values      = NULL;
+            key->value_hash  = NULL;
             key->modif       = modif;
             key->timestamp_counter = 0;
             list_init( &key->notify_list );
@@ -1056,6 +1211,10 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
     free( key->obj.name );
     key->obj.name = new_name_ptr;
 
+    /* the indices have moved, rebuild the hash index on next lookup */
+    free( parent->subkey_hash );
+    parent->subkey_hash = NULL;
+
     if (debug_level > 1) dump_operation( key, NULL, "Rename" );
     touch_key( key, REG_NOTIFY_CHANGE_NAME );
 }
@@ -1122,11 +1281,18 @@ static int grow_values( struct key *key )
 }
 
 /* find the named value of a given key and return its index in the array */
-static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index )
+static struct key_value *find_value( struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
 
+    if (!key->value_hash) key->value_hash = create_name_hash( key, key->last_value + 1, get_value_name );
+    if (key->value_hash && (i = name_hash_find( key->value_hash, key, name, get_value_name )) != -1)
+    {
+        *index = i;
+        return &key->values[i];
+    }
+
     min = 0;
     max = key->last_value;
     while (min <= max)
@@ -1170,6 +1336,7 @@ static struct key_value *insert_value( struct key *key, const struct unicode_str
     value->namelen = name->len;
     value->len     = 0;
     value->data    = NULL;
+    name_hash_insert( &key->value_hash, name, index, key->last_value + 1 );
     return value;
 }
 
@@ -1328,6 +1495,7 @@ static void delete_value( struct key *key, const struct unicode_str *name )
         return;
     }
     if (debug_level > 1) dump_operation( key, value, "Delete" );
+    name_hash_remove( &key->value_hash, key, name, index, key->last_value + 1, get_value_name );
     free( value->name );
     free( value->data );
     for (i = index; i < key->last_value; i++) key->values[i] = key->values[i + 1];
@@ -1451,6 +1619,97 @@ static int get_data_type( const char *buffer, int *type, int *parse_type )
     return 0;
 }
 
+/* release the keys of the last loaded path */
+static void release_loaded_path( struct file_load_info *info, int depth )
+{
+    while (info->depth > depth) release_object( info->keys[--info->depth] );
+}
+
+/* recursively create a loaded key, like create_key_recursive() */
+/* keys are usually sorted in the file, so the elements shared with the last path are reused */
+static struct key *load_key_path( struct key *base, const struct unicode_str *name,
+                                  struct file_load_info *info )
+{
+    struct key *key = NULL, *parent = (struct key *)grab_object( base );
+    struct unicode_str tmp;
+    const WCHAR *str = name->str;
+    data_size_t len = name->len, common = 0, end;
+    int depth = 0;
+
+    while (common < name->len && common < info->pathlen &&
+           name->str[common / sizeof(WCHAR)] == info->path[common / sizeof(WCHAR)])
+        common += sizeof(WCHAR);
+
+    while (len)
+    {
+        tmp.str = str;
+        tmp.len = get_path_element( str, len );
+        end = (str - name->str) * sizeof(WCHAR) + tmp.len;
+
+        if (depth < info->depth && end <= common &&
+            (end == info->pathlen || info->path[end / sizeof(WCHAR)] == '\\'))
+            key = (struct key *)grab_object( info->keys[depth] );
+        else
+        {
+            release_loaded_path( info, depth );
+            if (!(key = create_key_object( &parent->obj, &tmp, OBJ_OPENIF, 0, 0, NULL ))) break;
+            if (depth == info->maxdepth)
+            {
+                int new_max = max( 16, info->maxdepth * 2 );
+                struct key **new_keys = realloc( info->keys, new_max * sizeof(*new_keys) );
+                if (!new_keys)
+                {
+                    release_object( key );
+                    key = NULL;
+                    set_error( STATUS_NO_MEMORY );
+                    break;
+                }
+                info->keys = new_keys;
+                info->maxdepth = new_max;
+            }
+            info->keys[info->depth++] = (struct key *)grab_object( key );
+        }
+        release_object( parent );
+        parent = key;
+        depth++;
+
+        /* skip trailing \\ and move to the next element */
+        if (tmp.len < len)
+        {
+            tmp.len += sizeof(WCHAR);
+            str += tmp.len / sizeof(WCHAR);
+            len -= tmp.len;
+        }
+        else break;
+    }
+
+    if (!key)
+    {
+        release_object( parent );
+        release_loaded_path( info, 0 );
+        info->pathlen = 0;
+        return NULL;
+    }
+    release_loaded_path( info, depth );
+
+    if (info->pathsize < name->len)
+    {
+        data_size_t new_size = max( 256, name->len * 2 );
+        WCHAR *new_path = realloc( info->path, new_size );
+        if (!new_path)
+        {
+            release_loaded_path( info, 0 );
+            info->pathlen = 0;
+            return parent;
+        }
+        info->path = new_path;
+        info->pathsize = new_size;
+    }
+    memcpy( info->path, name->str, name->len );
+    info->pathlen = name->len;
+    return parent;
+}
+
 /* load and create a key from the input file */
 static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
                              struct file_load_info *info, timeout_t *modif )
@@ -1489,7 +1748,7 @@ static struct key *load_key( struct key *base, const char *buffer, int prefix_le
     }
     name.str = p;
     name.len = len - (p - info->tmp + 1) * sizeof(WCHAR);
-    return create_key_recursive( base, &name, 0 );
+    return load_key_path( base, &name, info );
 }
 
 /* update the modification time of a key (and its parents) after it has been loaded from a file */
@@ -1731,6 +1990,12 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     info.len    = 4;
     info.tmplen = 4;
     info.line   = 0;
+    info.path     = NULL;
+    info.pathlen  = 0;
+    info.pathsize = 0;
+    info.keys     = NULL;
+    info.depth    = 0;
+    info.maxdepth = 0;
     if (!(info.buffer = mem_alloc( info.len ))) return;
     if (!(info.tmp = mem_alloc( info.tmplen )))
     {
@@ -1785,6 +2050,9 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
         update_key_time( subkey, modif );
         release_object( subkey );
     }
+    release_loaded_path( &info, 0 );
+    free( info.keys );
+    free( info.path );
     free( info.buffer );
     free( info.tmp );
 }
@@ -2174,6 +2442,7 @@ static int save_branch( struct key *key, const char *path )
         close( fd );
         goto done;
     }
+    setvbuf( f, NULL, _IOFBF, 65536 );
 
     if (debug_level > 1)
     {
@@ -1228,7 +1228,9 @@ static int sock_dispatch_asyncs( struct sock *sock, int event, int error )
         if (async_waiting( &sock->read_q ))
         {
             if (debug_level) fprintf( stderr, "activating read queue for socket %p\n", sock );
-            async_wake_up( &sock->read_q, STATUS_ALERTED );
+            /* each datagram satisfies one request, let the client receive several at once */
+            if (sock->type == WS_SOCK_DGRAM) async_wake_up_batch( &sock->read_q );
+            else async_wake_up( &sock->read_q, STATUS_ALERTED );
         }
         event &= ~(POLLIN | POLLPRI);
     }
@@ -1238,7 +1240,8 @@ static int sock_dispatch_asyncs( struct sock *sock, int event, int error )
         if (async_waiting( &sock->write_q ))
         {
             if (debug_level) fprintf( stderr, "activating write queue for socket %p\n", sock );
-            async_wake_up( &sock->write_q, STATUS_ALERTED );
+            if (sock->type == WS_SOCK_DGRAM) async_wake_up_batch( &sock->write_q );
+            else async_wake_up( &sock->write_q, STATUS_ALERTED );
         }
         event &= ~POLLOUT;
     }
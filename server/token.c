@@ -46,6 +46,7 @@
 
 #define MAX_SUBAUTH_COUNT 1
 
+const struct luid SeLockMemoryPrivilege           = {  4, 0 };
 const struct luid SeIncreaseQuotaPrivilege        = {  5, 0 };
 const struct luid SeTcbPrivilege                  = {  7, 0 };
 const struct luid SeSecurityPrivilege             = {  8, 0 };
@@ -772,6 +773,7 @@ struct token *token_create_admin( unsigned primary, int impersonation_level, int
     {
         { SeChangeNotifyPrivilege, SE_PRIVILEGE_ENABLED },
         { SeTcbPrivilege, 0 },
+        { SeLockMemoryPrivilege, 0 },
         { SeSecurityPrivilege, 0 },
         { SeBackupPrivilege, 0 },
         { SeRestorePrivilege, 0 },
@@ -30,6 +30,7 @@
 #include "ntuser.h"
 
 #include "object.h"
+#include "file.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -255,6 +256,64 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* get the slot of a window in the shared window information array */
+static volatile struct window_shared_memory *get_window_shared( user_handle_t handle )
+{
+    static const WCHAR nameW[] = {'w','i','n','d','o','w','s'};
+    static const struct unicode_str name = {nameW, sizeof(nameW)};
+    static volatile struct window_shared_memory *shared;
+    static struct object *mapping;
+
+    if (!mapping)
+    {
+        struct object *dir = create_thread_map_directory();
+        void *ptr;
+
+        if (!dir) return NULL;
+        mapping = create_shared_mapping( dir, &name, ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1) *
+                                         sizeof(*shared), NULL, &ptr );
+        release_object( dir );
+        if (!mapping) return NULL;
+        make_object_permanent( mapping );
+        shared = ptr;
+    }
+    return &shared[((handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* publish the window information that clients can read without a server call */
+static void update_window_shared( struct window *win )
+{
+    volatile struct window_shared_memory *shared;
+
+    if (!win->handle || !(shared = get_window_shared( win->handle ))) return;
+
+    SHARED_WRITE_BEGIN( &shared->seq );
+    shared->handle      = win->handle;
+    shared->parent      = win->parent ? win->parent->handle : 0;
+    shared->owner       = win->owner;
+    shared->style       = win->style;
+    shared->ex_style    = win->ex_style;
+    shared->dpi         = win->dpi;
+    shared->instance    = win->instance;
+    shared->id          = win->id;
+    shared->user_data   = win->user_data;
+    shared->window_rect = win->window_rect;
+    shared->client_rect = win->client_rect;
+    SHARED_WRITE_END( &shared->seq );
+}
+
+/* clear the shared information of a window that is being destroyed */
+static void clear_window_shared( struct window *win )
+{
+    volatile struct window_shared_memory *shared;
+
+    if (!(shared = get_window_shared( win->handle ))) return;
+
+    SHARED_WRITE_BEGIN( &shared->seq );
+    shared->handle = 0;
+    SHARED_WRITE_END( &shared->seq );
+}
+
 /* link a window at the right place in the siblings list */
 static int link_window( struct window *win, struct window *previous )
 {
@@ -311,6 +370,7 @@ static int link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    update_window_shared( win );
     return old_prev != win->entry.prev;
 }
 
@@ -356,6 +416,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         win->is_linked = 0;
         win->is_orphan = 1;
     }
+    update_window_shared( win );
     return 1;
 }
 
@@ -1827,8 +1888,10 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_window_shared( child );
         }
     }
+    update_window_shared( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) set_clip_rectangle( win->desktop, NULL, 0 );
@@ -2045,6 +2108,7 @@ void free_window_handle( struct window *win )
     detach_window_thread( win );
 
     if (win->parent) set_parent_window( win, NULL );
+    clear_window_shared( win );
     free_user_handle( win->handle );
     win->handle = 0;
     release_object( win );
@@ -2100,6 +2164,7 @@ DECL_HANDLER(create_window)
     }
     win->style = req->style;
     win->ex_style = req->ex_style;
+    update_window_shared( win );
 
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
@@ -2167,6 +2232,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->top_window );
         }
     }
 
@@ -2179,6 +2245,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->msg_window );
         }
     }
 
@@ -2214,6 +2281,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_window_shared( win );
 }
 
 
@@ -2285,6 +2353,7 @@ DECL_HANDLER(set_window_info)
     if (req->flags & SET_WIN_USERDATA) win->user_data = req->user_data;
     if (req->flags & SET_WIN_EXTRA) memcpy( win->extra_bytes + req->extra_offset,
                                             &req->extra_value, req->extra_size );
+    if (req->flags & ~SET_WIN_EXTRA) update_window_shared( win );
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;